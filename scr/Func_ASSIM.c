@@ -1,9 +1,19 @@
 
 #include <stdio.h>
 #include <math.h>
+#include "def_struct.h"
 #include "Func_ASSIM.h"
 #include "Func_SSIM.h"
 
+static double ASSIM_index(
+    double image1_mean,
+    double image2_mean,
+    double image1_sd,
+    double image2_sd,
+    double image_cov,
+    double *power,
+    double small_thd
+);
 
 double ASSIM(
     double *image1,
@@ -26,7 +36,36 @@ double ASSIM(
     image1_sd = StandardDeviation(image1, image1_mean, NODATA, size);
     image2_sd = StandardDeviation(image2, image2_mean, NODATA, size);
     image_cov = covariance(image1, image2, image1_mean, image2_mean, NODATA, size);
+    return ASSIM_index(image1_mean, image2_mean, image1_sd, image2_sd, image_cov, power, small_thd);
+}
+
+double ASSIM_stats(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *power,
+    double small_thd
+)
+{
+    // ASSIM() of two images from their statistics (SSIM_stats())
+    double image_mean[2], image_sd[2], image_cov;
+    SSIM_moments(p_s1, centered1, p_s2, centered2, size, image_mean, image_sd, &image_cov);
+    return ASSIM_index(image_mean[0], image_mean[1], image_sd[0], image_sd[1], image_cov, power, small_thd);
+}
 
+static double ASSIM_index(
+    double image1_mean,
+    double image2_mean,
+    double image1_sd,
+    double image2_sd,
+    double image_cov,
+    double *power,
+    double small_thd
+)
+{
+    // the ASSIM from the moments of two images
     double SSIM_l, SSIM_c, SSIM_s, ASSIM;
 
     // similarity in amplitude
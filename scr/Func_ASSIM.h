@@ -1,6 +1,8 @@
 #ifndef FUNC_ASSIM
 #define FUNC_ASSIM
 
+#include "def_struct.h"
+
 
 double ASSIM(
     double *image1,
@@ -11,4 +13,14 @@ double ASSIM(
     double small_thd
 );
 
+double ASSIM_stats(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *power,
+    double small_thd
+);
+
 #endif
\ No newline at end of file
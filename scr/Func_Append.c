@@ -0,0 +1,170 @@
+/*
+ * SUMMARY:      Func_Append.c
+ * USAGE:        append mode: disaggregate only the days after the end of FP_OUT
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  with APPEND,TRUE the last day already in the output is taken
+ *               from the state file FP_OUT.state (written at the end of each
+ *               run in append mode), or else from the last row of FP_OUT
+ *               (csv or sparse, plain file, not partitioned);
+ *               the target days up to this day are skipped by the disaggregation
+ *               (they remain as CONTINUITY context of the following days), and
+ *               the output of the new days is appended to the file(s).
+ *               without state file and FP_OUT, all the days are disaggregated.
+ * DESCRIP-END.
+ * FUNCTIONS:    append_last_day(); append_save_state();
+ *
+ * COMMENTS:
+ * state file: one row LAST_DAY,yyyy-mm-dd
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "def_struct.h"
+#include "Func_Initialize.h"
+#include "Func_Stream.h"
+#include "Func_Append.h"
+
+static void state_name(
+    char fname_state[],
+    char FP_OUT[])
+{
+    sprintf(fname_state, "%s.state", FP_OUT);
+}
+
+static int tail_last_day(
+    char fname[],
+    int n_skip,
+    struct Date *p_date)
+{
+    /**************
+     * Description:
+     *      the date of the last row of a (plain) csv or sparse output file
+     * Parameters:
+     *      n_skip: the number of columns before y,m,d (1: run)
+     * Output:
+     *      0: found; -1: the file does not exist or has no data rows
+     * ***********/
+    FILE *fp;
+    char *tail = NULL;
+    char *p = NULL;
+    long size, n, len = 4096;
+    int k, status;
+    if ((fp = fopen(fname, "rb")) == NULL)
+    {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    while (1)
+    {
+        /* the tail of the file, longer until it holds the whole last row */
+        n = (size < len) ? size : len;
+        tail = (char *)realloc(tail, n + 1);
+        fseek(fp, size - n, SEEK_SET);
+        n = (long)fread(tail, 1, n, fp);
+        tail[n] = '\0';
+        while (n > 0 && (tail[n - 1] == '\n' || tail[n - 1] == '\r'))
+        {
+            tail[--n] = '\0';
+        }
+        p = strrchr(tail, '\n');
+        if (p != NULL || len >= size)
+        {
+            break;
+        }
+        len *= 2;
+    }
+    fclose(fp);
+    p = (p == NULL) ? tail : p + 1;
+    if (n == 0 || *p == '#')
+    {
+        free(tail);
+        return -1;
+    }
+    for (k = 0; k < n_skip && p != NULL; k++)
+    {
+        if ((p = strchr(p, ',')) != NULL)
+        {
+            p++;
+        }
+    }
+    status = (p != NULL && sscanf(p, "%d,%d,%d", &p_date->y, &p_date->m, &p_date->d) == 3) ? 0 : -1;
+    free(tail);
+    return status;
+}
+
+int append_last_day(
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      find the last day already in the output and set p_gp->APPEND_AFTER
+     * Output:
+     *      the day number (day_number()) of the last day; -1: a new output
+     * ***********/
+    char fname_state[220];
+    char row[200];
+    struct Date last;
+    FILE *fp;
+    int found = -1;
+    if (strncmp(p_gp->OUT_FORMAT, "BINARY", 6) == 0 || is_std(p_gp->FP_OUT))
+    {
+        printf("Program terminated: APPEND is not possible with OUT_FORMAT,BINARY or the standard output\n");
+        exit(1);
+    }
+    state_name(fname_state, p_gp->FP_OUT);
+    if ((fp = fopen(fname_state, "r")) != NULL)
+    {
+        if (fgets(row, sizeof(row), fp) == NULL || sscanf(row, "LAST_DAY,%d-%d-%d", &last.y, &last.m, &last.d) != 3)
+        {
+            printf("Program terminated: invalid state file: %s\n", fname_state);
+            exit(1);
+        }
+        fclose(fp);
+        found = 0;
+    }
+    else if (strncmp(p_gp->OUT_PARTITION, "NONE", 4) == 0 && is_gz(p_gp->FP_OUT) == 0)
+    {
+        // the run column: sparse output, or csv with more than one run
+        found = tail_last_day(p_gp->FP_OUT, (p_gp->RUN > 1 || strncmp(p_gp->OUT_FORMAT, "SPARSE", 6) == 0), &last);
+    }
+    p_gp->APPEND_AFTER = (found == 0) ? day_number(last) : -1;
+    if (found == 0)
+    {
+        printf("------ Append: the output ends on %d-%02d-%02d, the later days are disaggregated\n", last.y, last.m, last.d);
+        if (FLAG_LOG == 1)
+        {
+            fprintf(p_log, "------ Append: the output ends on %d-%02d-%02d, the later days are disaggregated\n", last.y, last.m, last.d);
+        }
+    }
+    else
+    {
+        printf("------ Append: no previous output found, all the days are disaggregated\n");
+    }
+    return p_gp->APPEND_AFTER;
+}
+
+void append_save_state(
+    struct Para_global *p_gp,
+    struct Date last)
+{
+    // record the last day of the output, after the output is completely written
+    char fname_state[220];
+    FILE *fp;
+    state_name(fname_state, p_gp->FP_OUT);
+    if ((fp = fopen(fname_state, "w")) == NULL)
+    {
+        printf("Program terminated: cannot create state file: %s\n", fname_state);
+        exit(1);
+    }
+    fprintf(fp, "LAST_DAY,%d-%02d-%02d\n", last.y, last.m, last.d);
+    if (ferror(fp) != 0 || fclose(fp) != 0)
+    {
+        printf("Program terminated: error in writing state file: %s\n", fname_state);
+        exit(1);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef FUNC_APPEND
+#define FUNC_APPEND
+
+#include "def_struct.h"
+
+int append_last_day(
+    struct Para_global *p_gp
+);
+
+void append_save_state(
+    struct Para_global *p_gp,
+    struct Date last
+);
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ * SUMMARY:      Func_Archive.c
+ * USAGE:        compile the hourly observations into a binary archive and load it
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the hourly rr data file (FP_HOURLY) is parsed, aggregated and
+ *               classified (cp, season, class, wet-dry) only once; the result is
+ *               stored in a versioned binary file (FP_ARCHIVE). The following runs
+ *               map this file into memory: the hourly and daily blocks are used
+ *               in place, only the dates and classes are copied into df_rr_h.
+ * DESCRIP-END.
+ * FUNCTIONS:    load_archive(); write_archive();
+ *
+ * COMMENTS:
+ * layout of the archive file (native byte order):
+ *      struct archive_header (padded to ARCHIVE_HEAD bytes)
+ *      int date[ndays][3], cp[ndays], SM[ndays], class[ndays], wd[ndays]
+ *      double rr_d[ndays][N_STATION]            (8-byte aligned)
+ *      double rr_h[ndays][N_STATION][24]
+ * the archive is compiled again automatically when it does not fit the
+ * current run: other N_STATION or classification parameters, or FP_HOURLY
+ * (FP_CP) has been modified since.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "def_struct.h"
+#include "Func_mmap.h"
+#include "Func_Archive.h"
+
+#define ARCHIVE_HEAD 256
+#define ARCHIVE_MAGIC "KNNMOFH"
+
+extern FILE *p_log;
+extern int FLAG_LOG;
+
+static struct file_map archive_map; // kept mapped until the end of the program
+
+static void archive_classify(
+    struct Para_global *p_gp,
+    int classify[])
+{
+    // the parameters which the class field of the archive depends on
+    classify[0] = (strncmp(p_gp->T_CP, "TRUE", 4) == 0);
+    classify[1] = (strncmp(p_gp->MONTH, "TRUE", 4) == 0);
+    classify[2] = (strncmp(p_gp->SEASON, "TRUE", 4) == 0);
+    classify[3] = classify[2] ? p_gp->SUMMER_FROM : 0;
+    classify[4] = classify[2] ? p_gp->SUMMER_TO : 0;
+}
+
+static void archive_source(
+    char fname[],
+    long long *size,
+    long long *mtime)
+{
+    // size and modification time of a source data file; -1 if not available
+    struct stat st;
+    if (stat(fname, &st) == 0)
+    {
+        *size = (long long)st.st_size;
+        *mtime = (long long)st.st_mtime;
+    }
+    else
+    {
+        *size = -1;
+        *mtime = -1;
+    }
+}
+
+int load_archive(
+    struct Para_global *p_gp,
+    struct df_rr_h **p_rr_h)
+{
+    /**************
+     * Description:
+     *      map the binary hourly archive and fill the df_rr_h struct array
+     * Parameters:
+     *      p_gp: global parameters, FP_ARCHIVE
+     *      p_rr_h: pointing to the df_rr_h struct array, allocated here
+     * Output:
+     *      the number of hourly observation days;
+     *      -1: no archive, or the archive is out of date (to be compiled again)
+     * ***********/
+    struct archive_header head;
+    int classify[5];
+    long long size, mtime;
+    int i, N;
+
+    if (map_file(p_gp->FP_ARCHIVE, &archive_map) != 0 || archive_map.size < ARCHIVE_HEAD)
+    {
+        unmap_file(&archive_map);
+        return -1;
+    }
+    memcpy(&head, archive_map.data, sizeof(struct archive_header));
+    archive_classify(p_gp, classify);
+    N = p_gp->N_STATION;
+    if (
+        strncmp(head.magic, ARCHIVE_MAGIC, 8) != 0 || head.version != ARCHIVE_VERSION ||
+        head.byte_order != 0x01020304 || head.N_STATION != N ||
+        head.ndays <= 0 ||
+        memcmp(head.classify, classify, sizeof(classify)) != 0 ||
+        head.off_rr_h + (long long)(sizeof(double) * 24) * head.ndays * N > (long long)archive_map.size)
+    {
+        printf("* FP_ARCHIVE: %s does not fit the current parameters, compile it again.\n", p_gp->FP_ARCHIVE);
+        unmap_file(&archive_map);
+        return -1;
+    }
+    /* the source files are not necessarily kept next to the archive */
+    archive_source(p_gp->FP_HOURLY, &size, &mtime);
+    if (size >= 0 && (size != head.src_size[0] || mtime != head.src_mtime[0]))
+    {
+        printf("* FP_ARCHIVE: %s is older than FP_HOURLY, compile it again.\n", p_gp->FP_ARCHIVE);
+        unmap_file(&archive_map);
+        return -1;
+    }
+    if (classify[0] == 1)
+    {
+        archive_source(p_gp->FP_CP, &size, &mtime);
+        if (size >= 0 && (size != head.src_size[1] || mtime != head.src_mtime[1]))
+        {
+            printf("* FP_ARCHIVE: %s is older than FP_CP, compile it again.\n", p_gp->FP_ARCHIVE);
+            unmap_file(&archive_map);
+            return -1;
+        }
+    }
+
+    int *date = (int *)(archive_map.data + head.off_date);
+    int *cp = (int *)(archive_map.data + head.off_cp);
+    int *SM = (int *)(archive_map.data + head.off_SM);
+    int *class = (int *)(archive_map.data + head.off_class);
+    int *wd = (int *)(archive_map.data + head.off_wd);
+    double *rr_d = (double *)(archive_map.data + head.off_rr_d);
+    double *rr_h = (double *)(archive_map.data + head.off_rr_h);
+    struct df_rr_h *p_df;
+    *p_rr_h = (struct df_rr_h *)calloc(head.ndays, sizeof(struct df_rr_h));
+    for (i = 0; i < head.ndays; i++)
+    {
+        p_df = *p_rr_h + i;
+        p_df->date.y = date[i * 3 + 0];
+        p_df->date.m = date[i * 3 + 1];
+        p_df->date.d = date[i * 3 + 2];
+        p_df->cp = cp[i];
+        p_df->SM = SM[i];
+        p_df->class = class[i];
+        p_df->wd = wd[i];
+        /* zero-copy: the rr values are read from the mapped file directly */
+        p_df->rr_d = rr_d + (size_t)i * N;
+        p_df->rr_h = (double (*)[24])(rr_h + (size_t)i * N * 24);
+    }
+    return head.ndays;
+}
+
+void write_archive(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int ndays_h)
+{
+    /**************
+     * Description:
+     *      compile the (imported and initialized) hourly observations
+     *      into the binary archive FP_ARCHIVE
+     * Parameters:
+     *      p_gp: global parameters
+     *      p_rr_h: the df_rr_h struct array, after initialize_dfrr_h() and initialize_dfrr_wd()
+     *      ndays_h: the number of hourly observation days
+     * ***********/
+    struct archive_header head;
+    char head_block[ARCHIVE_HEAD];
+    char fname_tmp[210];
+    FILE *fp;
+    int i, k, N;
+    int field[3];
+    time_t tm;
+
+    N = p_gp->N_STATION;
+    memset(&head, 0, sizeof(struct archive_header));
+    memcpy(head.magic, ARCHIVE_MAGIC, 8);
+    head.version = ARCHIVE_VERSION;
+    head.byte_order = 0x01020304;
+    head.N_STATION = N;
+    head.ndays = ndays_h;
+    archive_classify(p_gp, head.classify);
+    archive_source(p_gp->FP_HOURLY, &head.src_size[0], &head.src_mtime[0]);
+    if (head.classify[0] == 1)
+    {
+        archive_source(p_gp->FP_CP, &head.src_size[1], &head.src_mtime[1]);
+    }
+    head.off_date = ARCHIVE_HEAD;
+    head.off_cp = head.off_date + (long long)ndays_h * 3 * sizeof(int);
+    head.off_SM = head.off_cp + (long long)ndays_h * sizeof(int);
+    head.off_class = head.off_SM + (long long)ndays_h * sizeof(int);
+    head.off_wd = head.off_class + (long long)ndays_h * sizeof(int);
+    head.off_rr_d = head.off_wd + (long long)ndays_h * sizeof(int);
+    head.off_rr_d = (head.off_rr_d + 7) / 8 * 8; // 8-byte aligned for doubles
+    head.off_rr_h = head.off_rr_d + (long long)ndays_h * N * sizeof(double);
+
+    /* write into a temporary file first; never leave a half-written archive behind */
+    snprintf(fname_tmp, sizeof(fname_tmp), "%s.tmp", p_gp->FP_ARCHIVE);
+    if ((fp = fopen(fname_tmp, "wb")) == NULL)
+    {
+        printf("Cannot create binary archive file: %s\n", fname_tmp);
+        exit(1);
+    }
+    memset(head_block, 0, ARCHIVE_HEAD);
+    memcpy(head_block, &head, sizeof(struct archive_header));
+    fwrite(head_block, 1, ARCHIVE_HEAD, fp);
+    for (i = 0; i < ndays_h; i++)
+    {
+        field[0] = (p_rr_h + i)->date.y;
+        field[1] = (p_rr_h + i)->date.m;
+        field[2] = (p_rr_h + i)->date.d;
+        fwrite(field, sizeof(int), 3, fp);
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite(&(p_rr_h + i)->cp, sizeof(int), 1, fp);
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite(&(p_rr_h + i)->SM, sizeof(int), 1, fp);
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite(&(p_rr_h + i)->class, sizeof(int), 1, fp);
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite(&(p_rr_h + i)->wd, sizeof(int), 1, fp);
+    }
+    for (k = (int)(head.off_wd + (long long)ndays_h * sizeof(int)); k < head.off_rr_d; k++)
+    {
+        fputc(0, fp); // padding
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite((p_rr_h + i)->rr_d, sizeof(double), N, fp);
+    }
+    for (i = 0; i < ndays_h; i++)
+    {
+        fwrite((p_rr_h + i)->rr_h, sizeof(double) * 24, N, fp);
+    }
+    if (ferror(fp) != 0 || fclose(fp) != 0)
+    {
+        printf("Error in writing binary archive file: %s\n", fname_tmp);
+        exit(1);
+    }
+    remove(p_gp->FP_ARCHIVE);
+    if (rename(fname_tmp, p_gp->FP_ARCHIVE) != 0)
+    {
+        printf("Cannot create binary archive file: %s\n", p_gp->FP_ARCHIVE);
+        exit(1);
+    }
+
+    time(&tm);
+    printf("------ Compile hourly archive %s (Done): %s", p_gp->FP_ARCHIVE, ctime(&tm));
+    if (FLAG_LOG == 1)
+    {
+        fprintf(p_log, "------ Compile hourly archive %s (Done): %s", p_gp->FP_ARCHIVE, ctime(&tm));
+    }
+}
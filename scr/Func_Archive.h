@@ -0,0 +1,41 @@
+#ifndef FUNC_ARCHIVE
+#define FUNC_ARCHIVE
+
+#define ARCHIVE_VERSION 1
+
+struct archive_header
+{
+    /*
+     * header of the binary (compiled) hourly archive;
+     * all offsets are in bytes from the beginning of the file
+     */
+    char magic[8];              // "KNNMOFH"
+    int version;                // ARCHIVE_VERSION
+    int byte_order;             // 0x01020304, written in native order
+    int N_STATION;
+    int ndays;                  // number of hourly observation days
+    int classify[5];            // T_CP, MONTH, SEASON, SUMMER_FROM, SUMMER_TO
+    int pad;
+    long long src_size[2];      // size of FP_HOURLY and FP_CP when compiled
+    long long src_mtime[2];     // modification time of FP_HOURLY and FP_CP
+    long long off_date;         // int  [ndays][3]: y, m, d
+    long long off_cp;           // int  [ndays]
+    long long off_SM;           // int  [ndays]
+    long long off_class;        // int  [ndays]
+    long long off_wd;           // int  [ndays]
+    long long off_rr_d;         // double [ndays][N_STATION]
+    long long off_rr_h;         // double [ndays][N_STATION][24]
+};
+
+int load_archive(
+    struct Para_global *p_gp,
+    struct df_rr_h **p_rr_h
+);
+
+void write_archive(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int ndays_h
+);
+
+#endif
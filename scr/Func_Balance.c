@@ -0,0 +1,275 @@
+/*
+ * SUMMARY:      Func_Balance.c
+ * USAGE:        verify the mass balance of the disaggregation on a side thread
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the 24 hourly rr of a station should sum up to the daily rr of the
+ *               target day. With FP_BALANCE each disaggregated day and run is
+ *               handed over (copied) to a verifying thread through a bounded
+ *               queue, the disaggregation only waits when the queue is full.
+ *               two kinds of violations are reported in FP_BALANCE:
+ *               - RECURSION: the hourly sum differs from the daily rr (e.g. a wet
+ *                 site left without fragment)
+ *               - ROUNDING: the sum of the hourly rr as written ("%.2f") differs
+ *                 from the daily rr by more than BALANCE_TOL
+ * DESCRIP-END.
+ * FUNCTIONS:    balance_open(); balance_add(); balance_sync(); balance_close();
+ *
+ * COMMENTS:
+ * FP_BALANCE (csv): type,date,run,station,daily,sum_hourly,sum_written
+ * the days with missing daily rr (< 0, NODATA) are not verified.
+ * restart from a checkpoint: the report is cut back to its size at the
+ * checkpoint; the counts of the summary cover the days after it only.
+ * the sums over the 24 hours are vectorized reductions (omp simd, when the
+ * compiler supports -fopenmp-simd; otherwise the pragma is ignored).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "def_struct.h"
+#include "Func_Format.h"
+#include "Func_Checkpoint.h"
+#include "Func_Balance.h"
+
+struct balance_job
+{
+    /* one disaggregated day and run, copied for the verifying thread */
+    struct Date date;
+    int run;
+    double *rr_d;               // [N_STATION]: the daily rr of the target day
+    double *rr_h;               // [N_STATION][24]: the disaggregated hourly rr
+};
+
+static FILE *fp_balance = NULL;
+static struct balance_job *jobs = NULL; // ring buffer of BALANCE_QUEUE jobs
+static int head = 0;
+static int count = 0;
+static int stop = 0;
+static int N = 0;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t not_full = PTHREAD_COND_INITIALIZER;
+static long long n_checked = 0;         // station-day-runs verified
+static long long n_recursion = 0;
+static long long n_rounding = 0;
+static double max_recursion = 0.0;
+static double max_rounding = 0.0;
+
+static double hour_sum(
+    const double *x)
+{
+    // the sum of 24 hourly values
+    double sum = 0.0;
+    int h;
+#pragma omp simd reduction(+ : sum)
+    for (h = 0; h < 24; h++)
+    {
+        sum += x[h];
+    }
+    return sum;
+}
+
+static long long hour_sum_written(
+    const double *x)
+{
+    // the sum of 24 hourly values as written "%.2f", in 0.01 mm
+    long long sum = 0;
+    int h;
+#pragma omp simd reduction(+ : sum)
+    for (h = 0; h < 24; h++)
+    {
+        sum += round_fixed2(x[h]);
+    }
+    return sum;
+}
+
+static void balance_check(
+    struct balance_job *p_job)
+{
+    // verify one day and run; called on the verifying thread only
+    double sum, dev, dev_written;
+    long long sum_written;
+    int j;
+    for (j = 0; j < N; j++)
+    {
+        if (p_job->rr_d[j] < 0.0)
+        {
+            continue; // NODATA
+        }
+        n_checked++;
+        sum = hour_sum(p_job->rr_h + j * 24);
+        sum_written = hour_sum_written(p_job->rr_h + j * 24);
+        dev = fabs(sum - p_job->rr_d[j]);
+        dev_written = llabs(sum_written - round_fixed2(p_job->rr_d[j])) / 100.0;
+        if (dev > 1e-6 * (1.0 + p_job->rr_d[j]))
+        {
+            n_recursion++;
+            max_recursion = (dev > max_recursion) ? dev : max_recursion;
+            fprintf(
+                fp_balance, "RECURSION,%d-%02d-%02d,%d,%d,%.4f,%.4f,%.2f\n",
+                p_job->date.y, p_job->date.m, p_job->date.d, p_job->run, j + 1,
+                p_job->rr_d[j], sum, sum_written / 100.0);
+        }
+        else if (dev_written > BALANCE_TOL + 1e-9)
+        {
+            n_rounding++;
+            max_rounding = (dev_written > max_rounding) ? dev_written : max_rounding;
+            fprintf(
+                fp_balance, "ROUNDING,%d-%02d-%02d,%d,%d,%.4f,%.4f,%.2f\n",
+                p_job->date.y, p_job->date.m, p_job->date.d, p_job->run, j + 1,
+                p_job->rr_d[j], sum, sum_written / 100.0);
+        }
+    }
+}
+
+static void *balance_thread(
+    void *arg)
+{
+    // the verifying thread: take the queued day-runs in order
+    struct balance_job *p_job;
+    (void)arg;
+    while (1)
+    {
+        pthread_mutex_lock(&lock);
+        while (count == 0 && stop == 0)
+        {
+            pthread_cond_wait(&not_empty, &lock);
+        }
+        if (count == 0 && stop == 1)
+        {
+            pthread_mutex_unlock(&lock);
+            break;
+        }
+        p_job = jobs + head;
+        pthread_mutex_unlock(&lock);
+
+        /* the job stays counted (not reused) until it is verified */
+        balance_check(p_job);
+
+        pthread_mutex_lock(&lock);
+        head = (head + 1) % BALANCE_QUEUE;
+        count -= 1;
+        pthread_cond_signal(&not_full);
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+void balance_open(
+    struct Para_global *p_gp)
+{
+    // create the report FP_BALANCE (restart: continue it) and start the verifying thread
+    int k;
+    long long offset = -1;
+    if (checkpoint_loaded() == 1 && (offset = checkpoint_offset(p_gp->FP_BALANCE)) >= 0)
+    {
+        checkpoint_truncate(p_gp->FP_BALANCE, offset);
+    }
+    if ((fp_balance = fopen(p_gp->FP_BALANCE, (offset >= 0) ? "a" : "w")) == NULL)
+    {
+        printf("Cannot create the mass balance report: %s\n", p_gp->FP_BALANCE);
+        exit(1);
+    }
+    if (offset < 0)
+    {
+        fprintf(fp_balance, "type,date,run,station,daily,sum_hourly,sum_written\n");
+    }
+    N = p_gp->N_STATION;
+    jobs = (struct balance_job *)calloc(BALANCE_QUEUE, sizeof(struct balance_job));
+    for (k = 0; k < BALANCE_QUEUE; k++)
+    {
+        jobs[k].rr_d = (double *)malloc(sizeof(double) * N);
+        jobs[k].rr_h = (double *)malloc(sizeof(double) * N * 24);
+        if (jobs[k].rr_d == NULL || jobs[k].rr_h == NULL)
+        {
+            printf("Memory allocation failed in the mass balance verifier\n");
+            exit(1);
+        }
+    }
+    if (pthread_create(&thread, NULL, balance_thread, NULL) != 0)
+    {
+        printf("Program terminated: cannot start the mass balance thread\n");
+        exit(1);
+    }
+}
+
+void balance_add(
+    struct df_rr_d *p_rrd,
+    struct df_rr_h *p_out,
+    int run)
+{
+    /**************
+     * Description:
+     *      queue a disaggregated day and run for the verification;
+     *      waits when the queue is full
+     * Parameters:
+     *      p_rrd: the target day (daily rr)
+     *      p_out: the disaggregated hourly rr of the day
+     *      run: the index of the simulation run, from 1
+     * ***********/
+    struct balance_job *p_job;
+    pthread_mutex_lock(&lock);
+    while (count == BALANCE_QUEUE)
+    {
+        pthread_cond_wait(&not_full, &lock);
+    }
+    p_job = jobs + (head + count) % BALANCE_QUEUE;
+    pthread_mutex_unlock(&lock);
+
+    /* the free slot is not touched by the verifying thread */
+    p_job->date = p_rrd->date;
+    p_job->run = run;
+    memcpy(p_job->rr_d, p_rrd->p_rr, sizeof(double) * N);
+    memcpy(p_job->rr_h, p_out->rr_h, sizeof(double) * N * 24);
+
+    pthread_mutex_lock(&lock);
+    count += 1;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&lock);
+}
+
+long long balance_sync()
+{
+    // checkpoint: wait until the queued day-runs are verified; the size of FP_BALANCE
+    pthread_mutex_lock(&lock);
+    while (count > 0)
+    {
+        pthread_cond_wait(&not_full, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+    fflush(fp_balance);
+    return ftell(fp_balance);
+}
+
+void balance_close()
+{
+    // verify the remaining day-runs, stop the thread and close the report
+    int k;
+    pthread_mutex_lock(&lock);
+    stop = 1;
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&lock);
+    pthread_join(thread, NULL);
+    printf(
+        "------ Mass balance: %lld station-days verified, %lld RECURSION (max %.4f mm), %lld ROUNDING (max %.2f mm)\n",
+        n_checked, n_recursion, max_recursion, n_rounding, max_rounding);
+    if (ferror(fp_balance) != 0 || fclose(fp_balance) != 0)
+    {
+        printf("Program terminated: error in writing the mass balance report\n");
+        exit(1);
+    }
+    fp_balance = NULL;
+    for (k = 0; k < BALANCE_QUEUE; k++)
+    {
+        free(jobs[k].rr_d);
+        free(jobs[k].rr_h);
+    }
+    free(jobs);
+    jobs = NULL;
+}
@@ -0,0 +1,23 @@
+#ifndef FUNC_BALANCE
+#define FUNC_BALANCE
+
+#include "def_struct.h"
+
+#define BALANCE_QUEUE 64        // day-runs queued for the verifying thread
+#define BALANCE_TOL 0.05        // mm: tolerated deviation of the written ("%.2f") hourly sum
+
+void balance_open(
+    struct Para_global *p_gp
+);
+
+void balance_add(
+    struct df_rr_d *p_rrd,
+    struct df_rr_h *p_out,
+    int run
+);
+
+long long balance_sync();
+
+void balance_close();
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * SUMMARY:      Func_BinOut.c
+ * USAGE:        compact binary output of the disaggregated hourly rr
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  with OUT_FORMAT,BINARY the hourly rr are stored as scaled 16-bit
+ *               integers (0.01 mm) instead of "%.2f" text: 2 bytes per value, and
+ *               no parsing when reading. The file can be converted back into the
+ *               csv layout of FP_OUT with the kNN_MOF_bin2csv tool (main_bin2csv.c).
+ * DESCRIP-END.
+ * FUNCTIONS:    binout_header_init(); binout_read_header(); binout_read_index();
+ *               Format_df_rr_h_bin();
+ *
+ * COMMENTS:
+ * layout of the binary output file (native byte order):
+ *      struct binout_header (padded to BINOUT_HEAD bytes)
+ *      day records, each of record_size bytes:
+ *          int date[3]: y, m, d
+ *          uint16_t rr[RUN][24][N_STATION]
+ *      long long index[ndays]: offset of each day record
+ * the values are rounded the same as "%.2f", so that the converted csv is
+ * identical to the text output as long as rr < 655.35 mm; larger, negative
+ * and NODATA values are stored as BINOUT_NODATA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "def_struct.h"
+#include "Func_BinOut.h"
+
+#define BINOUT_MAGIC "KNNMOFO"
+
+void binout_header_init(
+    struct binout_header *p_head,
+    struct Para_global *p_gp)
+{
+    // the header of a new binary output file; ndays and off_index are set when closing
+    memset(p_head, 0, sizeof(struct binout_header));
+    memcpy(p_head->magic, BINOUT_MAGIC, 8);
+    p_head->version = BINOUT_VERSION;
+    p_head->byte_order = 0x01020304;
+    p_head->N_STATION = p_gp->N_STATION;
+    p_head->RUN = p_gp->RUN;
+    p_head->scale = BINOUT_SCALE;
+    p_head->nodata = BINOUT_NODATA;
+    p_head->NODATA = p_gp->NODATA;
+    p_head->record_size = 3 * sizeof(int) + (long long)p_gp->RUN * 24 * p_gp->N_STATION * sizeof(uint16_t);
+    p_head->off_data = BINOUT_HEAD;
+}
+
+int binout_read_header(
+    FILE *fp,
+    struct binout_header *p_head)
+{
+    /**************
+     * Description:
+     *      read and check the header of a binary output file
+     * Output:
+     *      0: valid; -1: not a (complete) binary output file
+     * ***********/
+    if (fseek(fp, 0, SEEK_SET) != 0 || fread(p_head, sizeof(struct binout_header), 1, fp) != 1)
+    {
+        return -1;
+    }
+    if (
+        strncmp(p_head->magic, BINOUT_MAGIC, 8) != 0 || p_head->version != BINOUT_VERSION ||
+        p_head->byte_order != 0x01020304 || p_head->N_STATION <= 0 || p_head->RUN <= 0 ||
+        p_head->ndays < 0 || p_head->off_index < p_head->off_data)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+long long *binout_read_index(
+    FILE *fp,
+    struct binout_header *p_head)
+{
+    // the offsets of the day records; NULL if the index cannot be read
+    long long *index = (long long *)malloc(sizeof(long long) * (p_head->ndays + 1));
+    if (
+        fseek(fp, p_head->off_index, SEEK_SET) != 0 ||
+        fread(index, sizeof(long long), p_head->ndays, fp) != (size_t)p_head->ndays)
+    {
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void Format_df_rr_h_bin(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf)
+{
+    /**************
+     * Description:
+     *      append the hourly rr of one day and one run to the buffer, as the
+     *      block rr[24][N_STATION] of the day record; the date starts the record (run 1)
+     * Parameters:
+     *      p_out: the disaggregated hourly rr of the day
+     *      p_gp: global parameters (N_STATION)
+     *      run: the index of the simulation run, from 1
+     *      p_buf: the output buffer
+     * ***********/
+    int j, h, N;
+    long long n;
+    uint16_t *p_val;
+    N = p_gp->N_STATION;
+    if (run == 1)
+    {
+        int date[3] = {p_out->date.y, p_out->date.m, p_out->date.d};
+        buf_reserve(p_buf, sizeof(date));
+        memcpy(p_buf->data + p_buf->len, date, sizeof(date));
+        p_buf->len += sizeof(date);
+    }
+    buf_reserve(p_buf, sizeof(uint16_t) * 24 * N);
+    p_val = (uint16_t *)(p_buf->data + p_buf->len);
+    for (j = 0; j < N; j++)
+    {
+        for (h = 0; h < 24; h++)
+        {
+            n = round_fixed2(p_out->rr_h[j][h]);
+            p_val[h * N + j] = (n < 0 || n >= BINOUT_NODATA) ? BINOUT_NODATA : (uint16_t)n;
+        }
+    }
+    p_buf->len += sizeof(uint16_t) * 24 * N;
+}
@@ -0,0 +1,56 @@
+#ifndef FUNC_BINOUT
+#define FUNC_BINOUT
+
+#include <stdio.h>
+#include <stdint.h>
+#include "Func_Format.h"
+
+#define BINOUT_VERSION 1
+#define BINOUT_HEAD 128         // bytes reserved for the header
+#define BINOUT_SCALE 100        // stored value = rr * BINOUT_SCALE (0.01 mm)
+#define BINOUT_NODATA 65535     // stored value of NODATA, negative or out of range
+
+struct binout_header
+{
+    /*
+     * header of the binary output file (OUT_FORMAT,BINARY);
+     * all offsets are in bytes from the beginning of the file
+     */
+    char magic[8];              // "KNNMOFO"
+    int version;                // BINOUT_VERSION
+    int byte_order;             // 0x01020304, written in native order
+    int N_STATION;
+    int RUN;
+    int ndays;                  // number of day records
+    int scale;                  // BINOUT_SCALE
+    int nodata;                 // BINOUT_NODATA
+    int pad;
+    double NODATA;              // the NODATA value of the run, written back for BINOUT_NODATA
+    long long record_size;      // bytes of one day record
+    long long off_data;         // the first day record
+    long long off_index;        // long long [ndays]: offset of each day record
+};
+
+void binout_header_init(
+    struct binout_header *p_head,
+    struct Para_global *p_gp
+);
+
+int binout_read_header(
+    FILE *fp,
+    struct binout_header *p_head
+);
+
+long long *binout_read_index(
+    FILE *fp,
+    struct binout_header *p_head
+);
+
+void Format_df_rr_h_bin(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf
+);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * SUMMARY:      Func_Checkpoint.c
+ * USAGE:        checkpoints of a long disaggregation, and restart from the last one
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  with CHECKPOINT,n the state of the disaggregation is saved in
+ *               FP_OUT.ckpt every n target days:
+ *               - the last completed target day
+ *               - the state of the random number generator (SEED)
+ *               - the size of each open output file, after the queued output is written,
+ *                 and of FP_SSIM and FP_BALANCE, after their buffered records are written
+ *               with RESTART,TRUE these files are cut back to these sizes,
+ *               the generator is restored and the disaggregation continues with
+ *               the day after the checkpoint; with SEED the output and FP_SSIM are
+ *               then identical to those of an uninterrupted run (the summary
+ *               counts of FP_BALANCE cover the days after the checkpoint only).
+ * DESCRIP-END.
+ * FUNCTIONS:    checkpoint_init(); checkpoint_loaded(); checkpoint_offset(); checkpoint_truncate();
+ *               checkpoint_day(); checkpoint_done();
+ *
+ * COMMENTS:
+ * the checkpoint is written to FP_OUT.ckpt.tmp and renamed, so that a
+ * preemption while writing leaves the previous checkpoint intact.
+ * rows of the checkpoint file:
+ *      LAST_DAY,yyyy-mm-dd
+ *      RNG,state
+ *      FILE,size,file path and name
+ * the gzip output (.gz) and the standard output cannot be cut back, and are
+ * not possible with checkpoints.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "def_struct.h"
+#include "Func_Initialize.h"
+#include "Func_kNN.h"
+#include "Func_Stream.h"
+#include "Func_Diag.h"
+#include "Func_Balance.h"
+#include "Func_Checkpoint.h"
+
+static int ck_loaded = 0;
+static int ck_n_file = 0;
+static char (*ck_fname)[220] = NULL;
+static long long *ck_offset = NULL;
+static int ck_days = 0;             // target days since the last checkpoint
+
+static void checkpoint_name(
+    char fname_ckpt[],
+    char FP_OUT[])
+{
+    sprintf(fname_ckpt, "%s.ckpt", FP_OUT);
+}
+
+int checkpoint_init(
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      check the output for checkpoints; with RESTART read the checkpoint
+     *      FP_OUT.ckpt: the days up to LAST_DAY are skipped (p_gp->APPEND_AFTER),
+     *      the generator is restored
+     * Output:
+     *      0: restart from the checkpoint; -1: no checkpoint (to be) loaded
+     * ***********/
+    char fname_ckpt[220];
+    char row[512];
+    struct Date last;
+    unsigned long long state;
+    long long offset;
+    int n;
+    FILE *fp;
+    if (is_gz(p_gp->FP_OUT) || is_std(p_gp->FP_OUT))
+    {
+        printf("Program terminated: CHECKPOINT and RESTART are not possible with a gzip output or the standard output: %s\n", p_gp->FP_OUT);
+        exit(1);
+    }
+    if (p_gp->FLAG_RESTART == 0)
+    {
+        return -1;
+    }
+    checkpoint_name(fname_ckpt, p_gp->FP_OUT);
+    if ((fp = fopen(fname_ckpt, "r")) == NULL)
+    {
+        printf("------ Restart: no checkpoint found, the disaggregation starts from the beginning\n");
+        return -1;
+    }
+    if (
+        fgets(row, sizeof(row), fp) == NULL || sscanf(row, "LAST_DAY,%d-%d-%d", &last.y, &last.m, &last.d) != 3 ||
+        fgets(row, sizeof(row), fp) == NULL || sscanf(row, "RNG,%llu", &state) != 1)
+    {
+        printf("Program terminated: invalid checkpoint file: %s\n", fname_ckpt);
+        exit(1);
+    }
+    while (fgets(row, sizeof(row), fp) != NULL)
+    {
+        if (sscanf(row, "FILE,%lld,%n", &offset, &n) != 1 || offset < 0)
+        {
+            printf("Program terminated: invalid checkpoint file: %s\n", fname_ckpt);
+            exit(1);
+        }
+        row[strcspn(row, "\r\n")] = '\0';
+        ck_fname = realloc(ck_fname, sizeof(*ck_fname) * (ck_n_file + 1));
+        ck_offset = (long long *)realloc(ck_offset, sizeof(long long) * (ck_n_file + 1));
+        snprintf(ck_fname[ck_n_file], sizeof(*ck_fname), "%s", row + n);
+        ck_offset[ck_n_file] = offset;
+        ck_n_file++;
+    }
+    fclose(fp);
+    ck_loaded = 1;
+    p_gp->APPEND_AFTER = day_number(last);
+    if (p_gp->SEED != 0)
+    {
+        rng_seed(state);
+    }
+    printf("------ Restart: from the checkpoint of %d-%02d-%02d\n", last.y, last.m, last.d);
+    if (FLAG_LOG == 1)
+    {
+        fprintf(p_log, "------ Restart: from the checkpoint of %d-%02d-%02d\n", last.y, last.m, last.d);
+    }
+    return 0;
+}
+
+int checkpoint_loaded()
+{
+    // 1: restarting from a checkpoint
+    return ck_loaded;
+}
+
+long long checkpoint_offset(
+    char fname[])
+{
+    // the size of the output file at the checkpoint; -1: the file is not in the checkpoint
+    int i;
+    for (i = 0; i < ck_n_file; i++)
+    {
+        if (strcmp(ck_fname[i], fname) == 0)
+        {
+            return ck_offset[i];
+        }
+    }
+    return -1;
+}
+
+void checkpoint_truncate(
+    char fname[],
+    long long offset)
+{
+    // cut the output file back to its size at the checkpoint
+    FILE *fp;
+    int status;
+    if ((fp = fopen(fname, "r+b")) == NULL)
+    {
+        printf("Program terminated: cannot open the output file of the checkpoint: %s\n", fname);
+        exit(1);
+    }
+#ifdef _WIN32
+    status = _chsize_s(_fileno(fp), offset);
+#else
+    status = ftruncate(fileno(fp), (off_t)offset);
+#endif
+    fclose(fp);
+    if (status != 0)
+    {
+        printf("Program terminated: cannot cut back the output file: %s\n", fname);
+        exit(1);
+    }
+}
+
+static void checkpoint_save(
+    struct out_writer *p_w,
+    struct Para_global *p_gp,
+    struct Date date)
+{
+    /**************
+     * Description:
+     *      write the checkpoint after the target day date (all runs) is submitted
+     * ***********/
+    char fname_ckpt[220];
+    char fname_tmp[230];
+    FILE *fp;
+    int i;
+    writer_sync(p_w);
+    checkpoint_name(fname_ckpt, p_gp->FP_OUT);
+    sprintf(fname_tmp, "%s.tmp", fname_ckpt);
+    if ((fp = fopen(fname_tmp, "w")) == NULL)
+    {
+        printf("Program terminated: cannot create checkpoint file: %s\n", fname_tmp);
+        exit(1);
+    }
+    fprintf(fp, "LAST_DAY,%d-%02d-%02d\n", date.y, date.m, date.d);
+    fprintf(fp, "RNG,%llu\n", rng_get_state());
+    for (i = 0; i < p_w->n_file; i++)
+    {
+        if (p_w->files[i].is_open == 1)
+        {
+            fprintf(fp, "FILE,%lld,%s\n", p_w->files[i].n_byte, p_w->files[i].fname);
+        }
+    }
+    if (p_gp->flag_SSIM == 1)
+    {
+        fprintf(fp, "FILE,%lld,%s\n", diag_sync(), p_gp->FP_SSIM);
+    }
+    if (p_gp->FLAG_BALANCE == 1)
+    {
+        fprintf(fp, "FILE,%lld,%s\n", balance_sync(), p_gp->FP_BALANCE);
+    }
+    if (ferror(fp) != 0 || fclose(fp) != 0)
+    {
+        printf("Program terminated: error in writing checkpoint file: %s\n", fname_tmp);
+        exit(1);
+    }
+#ifdef _WIN32
+    remove(fname_ckpt); // rename() does not replace an existing file on Windows
+#endif
+    if (rename(fname_tmp, fname_ckpt) != 0)
+    {
+        printf("Program terminated: cannot create checkpoint file: %s\n", fname_ckpt);
+        exit(1);
+    }
+}
+
+void checkpoint_day(
+    struct out_writer *p_w,
+    struct Para_global *p_gp,
+    struct Date date)
+{
+    // count the completed target days, a checkpoint every CHECKPOINT days
+    if (p_gp->CHECKPOINT > 0 && ++ck_days >= p_gp->CHECKPOINT)
+    {
+        checkpoint_save(p_w, p_gp, date);
+        ck_days = 0;
+    }
+}
+
+void checkpoint_done(
+    struct Para_global *p_gp)
+{
+    // the disaggregation is complete: the checkpoint is no longer needed
+    char fname_ckpt[220];
+    checkpoint_name(fname_ckpt, p_gp->FP_OUT);
+    remove(fname_ckpt);
+}
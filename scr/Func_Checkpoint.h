@@ -0,0 +1,32 @@
+#ifndef FUNC_CHECKPOINT
+#define FUNC_CHECKPOINT
+
+#include "def_struct.h"
+#include "Func_Writer.h"
+
+int checkpoint_init(
+    struct Para_global *p_gp
+);
+
+int checkpoint_loaded();
+
+long long checkpoint_offset(
+    char fname[]
+);
+
+void checkpoint_truncate(
+    char fname[],
+    long long offset
+);
+
+void checkpoint_day(
+    struct out_writer *p_w,
+    struct Para_global *p_gp,
+    struct Date date
+);
+
+void checkpoint_done(
+    struct Para_global *p_gp
+);
+
+#endif
@@ -0,0 +1,221 @@
+/*
+ * SUMMARY:      Func_Diag.c
+ * USAGE:        SSIM diagnostics: the k nearest candidates of each target day
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  both disaggregation engines report the sorted candidates of each
+ *               sampling (each recursion depth) with diag_top(); the records are
+ *               collected in a buffer of the calling thread (DIAG_RING records)
+ *               and written to FP_SSIM in one block when the buffer is full,
+ *               so that the sampling is not slowed down by formatted writing.
+ *               SSIM_FORMAT,TEXT (default): csv rows target,ID,index_Frag,SSIM,candidate
+ *               SSIM_FORMAT,TEXT_DEPTH: csv rows target,depth,ID,index_Frag,SSIM,candidate
+ *               SSIM_FORMAT,BINARY: struct diag_header + struct diag_record [n]
+ * DESCRIP-END.
+ * FUNCTIONS:    diag_open(); diag_top(); diag_sync(); diag_close();
+ *
+ * COMMENTS:
+ * the binary file can be converted into csv with kNN_MOF_bin2csv.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "def_struct.h"
+#include "Func_Checkpoint.h"
+#include "Func_Diag.h"
+
+#define DIAG_MAGIC "KNNMOFD"
+
+struct diag_ring
+{
+    /* the records of one thread, not yet written */
+    struct diag_record rec[DIAG_RING];
+    int n;
+    struct diag_ring *next;     // all the buffers, flushed in diag_close()
+};
+
+static FILE *fp_diag = NULL;
+static int diag_binary = 0;
+static int diag_depth = 0;      // TEXT_DEPTH: the recursion depth in the csv rows
+static pthread_mutex_t diag_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct diag_ring *diag_rings = NULL;
+static _Thread_local struct diag_ring *p_ring = NULL;
+
+void diag_open(
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      create the diagnostics file FP_SSIM (TEXT or BINARY by SSIM_FORMAT);
+     *      restart: the file is cut back to its size at the checkpoint, and
+     *      the records of the days after it are appended
+     * ***********/
+    long long offset = -1;
+    const char *mode;
+    diag_binary = (strncmp(p_gp->SSIM_FORMAT, "BINARY", 6) == 0);
+    diag_depth = (strncmp(p_gp->SSIM_FORMAT, "TEXT_DEPTH", 10) == 0);
+    mode = diag_binary ? "wb" : "w";
+    if (checkpoint_loaded() == 1 && (offset = checkpoint_offset(p_gp->FP_SSIM)) >= 0)
+    {
+        checkpoint_truncate(p_gp->FP_SSIM, offset);
+        mode = diag_binary ? "ab" : "a";
+    }
+    if ((fp_diag = fopen(p_gp->FP_SSIM, mode)) == NULL)
+    {
+        printf("Cannot create / open SSIM file: %s\n", p_gp->FP_SSIM);
+        exit(1);
+    }
+    if (offset >= 0)
+    {
+        return; // the header is in the file already
+    }
+    if (diag_binary)
+    {
+        struct diag_header head;
+        memset(&head, 0, sizeof(struct diag_header));
+        memcpy(head.magic, DIAG_MAGIC, 8);
+        head.version = DIAG_VERSION;
+        head.byte_order = 0x01020304;
+        head.record_size = sizeof(struct diag_record);
+        fwrite(&head, sizeof(struct diag_header), 1, fp_diag);
+    }
+    else if (p_gp->FLAG_LOG == 1 && diag_depth)
+    {
+        fprintf(fp_diag, "target,depth,ID,index_Frag,SSIM,candidate\n");
+    }
+    else if (p_gp->FLAG_LOG == 1)
+    {
+        fprintf(fp_diag, "target,ID,index_Frag,SSIM,candidate\n");
+    }
+}
+
+static void diag_flush(
+    struct diag_ring *p_r)
+{
+    // write the records of one buffer; the caller holds diag_lock
+    int i;
+    struct diag_record *p;
+    if (diag_binary)
+    {
+        fwrite(p_r->rec, sizeof(struct diag_record), p_r->n, fp_diag);
+    }
+    else
+    {
+        for (i = 0; i < p_r->n; i++)
+        {
+            p = p_r->rec + i;
+            fprintf(fp_diag, "%d-%02d-%02d,", p->target / 10000, p->target / 100 % 100, p->target % 100);
+            if (diag_depth)
+            {
+                fprintf(fp_diag, "%d,", p->depth);
+            }
+            fprintf(fp_diag, "%d,%d,%f,%d-%02d-%02d\n",
+                    p->rank, p->candidate, p->score,
+                    p->candidate_date / 10000, p->candidate_date / 100 % 100, p->candidate_date % 100);
+        }
+    }
+    p_r->n = 0;
+}
+
+void diag_top(
+    struct Date target,
+    int depth,
+    int pool_cans[],
+    double score[],
+    int n_can,
+    struct df_rr_h *p_rrh)
+{
+    /**************
+     * Description:
+     *      record the k = sqrt(n_can) + 1 best candidates of a sampling
+     * Parameters:
+     *      target: the date of the target day
+     *      depth: recursion depth of the sampling, from 1
+     *      pool_cans, score: the candidates and their similarity, sorted by kNN_sampling()
+     *      n_can: the number of candidates
+     *      p_rrh: the hourly rr obs (dates of the candidates)
+     * ***********/
+    int i, size_pool;
+    struct diag_record *p;
+    struct Date *p_date;
+    if (fp_diag == NULL)
+    {
+        return;
+    }
+    if (p_ring == NULL)
+    {
+        p_ring = (struct diag_ring *)calloc(1, sizeof(struct diag_ring));
+        pthread_mutex_lock(&diag_lock);
+        p_ring->next = diag_rings;
+        diag_rings = p_ring;
+        pthread_mutex_unlock(&diag_lock);
+    }
+    size_pool = (int)sqrt(n_can) + 1;
+    if (size_pool > n_can)
+    {
+        size_pool = n_can;
+    }
+    for (i = 0; i < size_pool; i++)
+    {
+        if (p_ring->n == DIAG_RING)
+        {
+            pthread_mutex_lock(&diag_lock);
+            diag_flush(p_ring);
+            pthread_mutex_unlock(&diag_lock);
+        }
+        p = p_ring->rec + p_ring->n++;
+        p_date = &(p_rrh + pool_cans[i])->date;
+        p->score = score[i];
+        p->target = target.y * 10000 + target.m * 100 + target.d;
+        p->candidate = pool_cans[i];
+        p->candidate_date = p_date->y * 10000 + p_date->m * 100 + p_date->d;
+        p->depth = (short)depth;
+        p->rank = (short)i;
+    }
+}
+
+long long diag_sync()
+{
+    // checkpoint: write the buffered records of all the threads; the size of FP_SSIM
+    struct diag_ring *p_r;
+    long long size;
+    pthread_mutex_lock(&diag_lock);
+    for (p_r = diag_rings; p_r != NULL; p_r = p_r->next)
+    {
+        diag_flush(p_r);
+    }
+    fflush(fp_diag);
+    size = ftell(fp_diag);
+    pthread_mutex_unlock(&diag_lock);
+    return size;
+}
+
+void diag_close()
+{
+    // write the remaining records of all the threads, and close the file
+    struct diag_ring *p_r;
+    if (fp_diag == NULL)
+    {
+        return;
+    }
+    pthread_mutex_lock(&diag_lock);
+    for (p_r = diag_rings; p_r != NULL; p_r = diag_rings)
+    {
+        diag_flush(p_r);
+        diag_rings = p_r->next;
+        free(p_r);
+    }
+    p_ring = NULL;
+    pthread_mutex_unlock(&diag_lock);
+    if (ferror(fp_diag) != 0 || fclose(fp_diag) != 0)
+    {
+        printf("Error in writing SSIM file\n");
+        exit(1);
+    }
+    fp_diag = NULL;
+}
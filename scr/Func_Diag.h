@@ -0,0 +1,47 @@
+#ifndef FUNC_DIAG
+#define FUNC_DIAG
+
+#include "def_struct.h"
+
+#define DIAG_VERSION 1
+#define DIAG_RING 4096          // records buffered per thread before a flush
+
+struct diag_header
+{
+    /* header of the binary SSIM diagnostics file (SSIM_FORMAT,BINARY) */
+    char magic[8];              // "KNNMOFD"
+    int version;                // DIAG_VERSION
+    int byte_order;             // 0x01020304, written in native order
+    int record_size;            // sizeof(struct diag_record)
+    int pad;
+};
+
+struct diag_record
+{
+    /* one of the k nearest candidates of a target day */
+    double score;               // SSIM (or Manhattan distance) to the target day
+    int target;                 // the target day: yyyymmdd
+    int candidate;              // index of the candidate in the hourly obs
+    int candidate_date;         // the candidate day: yyyymmdd
+    short depth;                // recursion depth of the sampling, from 1
+    short rank;                 // rank of the candidate after sorting, from 0
+};
+
+void diag_open(
+    struct Para_global *p_gp
+);
+
+void diag_top(
+    struct Date target,
+    int depth,
+    int pool_cans[],
+    double score[],
+    int n_can,
+    struct df_rr_h *p_rrh
+);
+
+long long diag_sync();
+
+void diag_close();
+
+#endif
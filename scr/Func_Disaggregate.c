@@ -38,6 +38,10 @@
 #include "Func_dataIO.h"
 #include "Func_kNN.h"
 #include "Func_Fragments.h"
+#include "Func_Diag.h"
+#include "Func_Checkpoint.h"
+#include "Func_Initialize.h"
+#include "Func_Donor.h"
 
 void kNN_MOF_SSIM(
     struct df_rr_h *p_rrh,
@@ -70,19 +74,22 @@ void kNN_MOF_SSIM(
      * *************/
     int skip = 0;
     skip = (int)((p_gp->CONTINUITY - 1) / 2);
-    int pool_cans[MAXrow]; // the index of the candidates (a pool); the size is sufficient
+    int *pool_cans;        // the index of the candidates (a pool); the size is sufficient
+    pool_cans = (int *)malloc(sizeof(int) * (ndays_h + 1));
     int n_can;             // the number of candidates after all conditioning (cp and seasonality)
     int fragment;          // the index of df_rr_h structure with the final chosed fragments
 
-    FILE *p_FP_OUT;
-    if ((p_FP_OUT = fopen(p_gp->FP_OUT, "w")) == NULL)
-    {
-        printf("Program terminated: cannot create or open output file\n");
-        exit(1);
-    }
+    struct out_writer writer;
+    struct df_donor donor;
+    donor_build(&donor, p_rrh, ndays_h, p_gp);
+    writer_open(&writer, p_gp->FP_OUT, p_gp);
     for (i = 0; i < nrow_rr_d; i++)
     {
         // iterate each (possible) target day
+        if (day_number((p_rrd + i)->date) <= p_gp->APPEND_AFTER)
+        {
+            continue; // append mode or restart: already in the output
+        }
         df_rr_h_out.date = (p_rrd + i)->date;
         df_rr_h_out.rr_d = (p_rrd + i)->p_rr;                            // is this valid?; address transfer
         df_rr_h_out.rr_h = calloc(p_gp->N_STATION, sizeof(double) * 24); // allocate memory (stack);
@@ -102,7 +109,7 @@ void kNN_MOF_SSIM(
             for (size_t t = 0; t < p_gp->RUN; t++)
             {
                 /* write the disaggregation output */
-                Write_df_rr_h(&df_rr_h_out, p_gp, p_FP_OUT, t + 1);
+                Write_df_rr_h(&df_rr_h_out, p_gp, &writer, t + 1);
             }
         }
         else
@@ -113,7 +120,7 @@ void kNN_MOF_SSIM(
              * flexible in wet-dry status filtering
              * n_can: the number of candidates after wet-dry status filtering
              * ********/
-            n_can = Toggle_CONTINUITY(p_rrh, p_rrd + i, p_gp, ndays_h, pool_cans);
+            n_can = Toggle_CONTINUITY(&donor, p_rrd + i, p_gp, pool_cans);
             class_t = (p_rrd + i)->class;
             for (j = 0; j < n_can; j++)
             {
@@ -167,16 +174,20 @@ void kNN_MOF_SSIM(
             /*assign the sampled fragments to target day (disaggregation)*/
             for (size_t t = 0; t < p_gp->RUN; t++)
             {
-                Fragment_assign(p_rrh, &df_rr_h_out, p_gp, p_coor, index_fragment[t]);
+                Fragment_assign(&donor, &df_rr_h_out, p_gp, p_coor, index_fragment[t]);
                 /* write the disaggregation output */
-                Write_df_rr_h(&df_rr_h_out, p_gp, p_FP_OUT, t + 1);
+                Write_df_rr_h(&df_rr_h_out, p_gp, &writer, t + 1);
             }
         }
+        writer_submit(&writer);
+        checkpoint_day(&writer, p_gp, (p_rrd + i)->date);
 
         printf("%d-%02d-%02d: Done!\n", (p_rrd + i)->date.y, (p_rrd + i)->date.m, (p_rrd + i)->date.d);
         free(df_rr_h_out.rr_h); // free the memory allocated for disaggregated hourly output
     }
-    fclose(p_FP_OUT);
+    writer_close(&writer);
+    donor_free(&donor);
+    free(pool_cans);
 }
 
 void kNN_SSIM_sampling(
@@ -273,14 +284,7 @@ void kNN_SSIM_sampling(
      * ********/
     if (p_gp->flag_SSIM == 1)
     {
-        int size_pool; // the k in kNN
-        size_pool = (int)sqrt(n_can) + 1;
-        for (i = 0; i < size_pool; i++)
-        {
-            fprintf(p_SSIM, "%d-%02d-%02d,", (p_rrd + index_target)->date.y, (p_rrd + index_target)->date.m, (p_rrd + index_target)->date.d);
-            fprintf(p_SSIM, "%d,%d,%f,", i, pool_cans[i], SSIM[i]);
-            fprintf(p_SSIM, "%d-%02d-%02d\n", (p_rrh + pool_cans[i])->date.y, (p_rrh + pool_cans[i])->date.m, (p_rrh + pool_cans[i])->date.d);
-        }
+        diag_top((p_rrd + index_target)->date, 1, pool_cans, SSIM, n_can, p_rrh);
     }
 
     free(SSIM);
@@ -0,0 +1,274 @@
+/*
+ * SUMMARY:      Func_Donor.c
+ * USAGE:        the hourly obs (donor days) in a contiguous structure-of-arrays layout
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the candidate filtering and scoring read the class, wet-dry
+ *               status and daily rr of many donor days for each target day;
+ *               struct df_donor keeps them as parallel arrays and matrices
+ *               [ndays][N_STATION] ([ndays][N_STATION][24] for the hourly rr).
+ *               the donors are partitioned once into buckets of class and
+ *               wet-dry status; the daily rr (rr_d, rr_d_pre) and the wet masks
+ *               of a bucket are adjacent rows, so the candidates of a target day
+ *               are one bucket read directly (Filter_WD_Class()).
+ *               the block of rr_h is taken over from the df_rr_h struct array
+ *               when it is contiguous already (all the loaders allocate it so);
+ *               otherwise it is compacted and the pointers of df_rr_h are moved
+ *               into the new block.
+ *               the fragments (the hourly weights rr_h / rr_d of each wet donor
+ *               site) are computed once here in float precision; the assignment
+ *               of a donor is then a multiplication of its weights.
+ *               the wet-dry status of each donor day is kept as a wet mask of
+ *               N_STATION bits (64 per word), compared word-wise in filtering.
+ *               the SSIM statistics of each donor day (valid count, sum, sum of
+ *               squares, max and the centered image, see SSIM_stats()) are
+ *               computed once for the scoring of the candidates.
+ * DESCRIP-END.
+ * FUNCTIONS:    donor_build(); donor_free();
+ *
+ * COMMENTS:
+ * the table is built after the classification (and preprocessing) of the
+ * hourly obs; the donors are addressed by their index k in df_rr_h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "def_struct.h"
+#include "Func_SSIM.h"
+#include "Func_Donor.h"
+
+static void build_bucket(
+    struct df_donor *p_don)
+{
+    // the bucket order of the donor days: by class and wd, then by day (stable)
+    // days without a class (class < 0, e.g. cp <= 0) are in no bucket: rows after the last one
+    int k, b, rest;
+    p_don->n_bucket = 2;
+    for (k = 0; k < p_don->ndays; k++)
+    {
+        if (p_don->class[k] * 2 + 2 > p_don->n_bucket)
+        {
+            p_don->n_bucket = p_don->class[k] * 2 + 2;
+        }
+    }
+    p_don->bucket_from = (int *)calloc(p_don->n_bucket + 1, sizeof(int));
+    p_don->bucket = (int *)malloc(sizeof(int) * (p_don->ndays + 1));
+    p_don->row = (int *)malloc(sizeof(int) * (p_don->ndays + 1));
+    if (p_don->bucket_from == NULL || p_don->bucket == NULL || p_don->row == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (k = 0; k < p_don->ndays; k++)
+    {
+        if (p_don->class[k] >= 0)
+        {
+            p_don->bucket_from[p_don->class[k] * 2 + p_don->wd[k] + 1]++;
+        }
+    }
+    for (b = 0; b < p_don->n_bucket; b++)
+    {
+        p_don->bucket_from[b + 1] += p_don->bucket_from[b];
+    }
+    rest = p_don->bucket_from[p_don->n_bucket];
+    for (k = 0; k < p_don->ndays; k++)
+    {
+        if (p_don->class[k] < 0)
+        {
+            p_don->row[k] = rest++;
+        }
+        else
+        {
+            /* the next free row of the bucket: bucket_from[b + 1] is restored below */
+            b = p_don->class[k] * 2 + p_don->wd[k];
+            p_don->row[k] = p_don->bucket_from[b]++;
+        }
+        p_don->bucket[p_don->row[k]] = k;
+    }
+    for (b = p_don->n_bucket; b > 0; b--)
+    {
+        p_don->bucket_from[b] = p_don->bucket_from[b - 1];
+    }
+    p_don->bucket_from[0] = 0;
+}
+
+static double *block_rr_d(
+    struct df_donor *p_don,
+    struct df_rr_h *p_rrh,
+    int pre)
+{
+    /**************
+     * Description:
+     *      the [ndays][N] block of rr_d (pre == 0) or rr_d_pre (pre == 1),
+     *      rows in the bucket order
+     * ***********/
+    double *block;
+    int r, N = p_don->N;
+    if ((block = (double *)malloc(sizeof(double) * N * ((size_t)p_don->ndays + 1))) == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (r = 0; r < p_don->ndays; r++)
+    {
+        memcpy(
+            block + (size_t)r * N,
+            (pre == 0) ? p_rrh[p_don->bucket[r]].rr_d : p_rrh[p_don->bucket[r]].rr_d_pre,
+            sizeof(double) * N);
+    }
+    return block;
+}
+
+static void build_frag(
+    struct df_donor *p_don)
+{
+    // the fragments of all the donor station-days; the dry ones are 0
+    double *rr_d;
+    double (*rr_h)[24];
+    size_t k;
+    int j, h;
+    p_don->frag = (float (*)[24])calloc((size_t)p_don->N * p_don->ndays + 1, sizeof(float) * 24);
+    if (p_don->frag == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (k = 0; k < (size_t)p_don->ndays; k++)
+    {
+        rr_d = donor_rr_d(p_don, k);
+        rr_h = donor_rr_h(p_don, k);
+        for (j = 0; j < p_don->N; j++)
+        {
+            if (rr_d[j] > 0.0)
+            {
+                for (h = 0; h < 24; h++)
+                {
+                    p_don->frag[k * p_don->N + j][h] = (float)(rr_h[j][h] / rr_d[j]);
+                }
+            }
+        }
+    }
+}
+
+void donor_build(
+    struct df_donor *p_don,
+    struct df_rr_h *p_rrh,
+    int ndays_h,
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      build the donor table of the hourly obs
+     * Parameters:
+     *      p_don: the table, filled here
+     *      p_rrh: the hourly obs, classified (class, wd) and preprocessed (if any)
+     *      ndays_h: the number of hourly observation days
+     *      p_gp: global parameters (N_STATION, NODATA, PREPROCESS)
+     * ***********/
+    double (*block)[24];
+    int k;
+    int N_STATION = p_gp->N_STATION;
+    memset(p_don, 0, sizeof(struct df_donor));
+    p_don->ndays = ndays_h;
+    p_don->N = N_STATION;
+    p_don->n_word = WD_WORDS(N_STATION);
+    p_don->date = (struct Date *)malloc(sizeof(struct Date) * (ndays_h + 1));
+    p_don->class = (int *)malloc(sizeof(int) * (ndays_h + 1));
+    p_don->wd = (int *)malloc(sizeof(int) * (ndays_h + 1));
+    if (p_don->date == NULL || p_don->class == NULL || p_don->wd == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (k = 0; k < ndays_h; k++)
+    {
+        p_don->date[k] = p_rrh[k].date;
+        p_don->class[k] = p_rrh[k].class;
+        p_don->wd[k] = p_rrh[k].wd;
+    }
+    if (ndays_h <= 0)
+    {
+        return;
+    }
+    build_bucket(p_don);
+    p_don->rr_d = block_rr_d(p_don, p_rrh, 0);
+    if (p_rrh[0].rr_d_pre != NULL)
+    {
+        p_don->rr_d_pre = block_rr_d(p_don, p_rrh, 1);
+    }
+    if ((p_don->mask = (uint64_t *)calloc((size_t)p_don->n_word * ndays_h + 1, sizeof(uint64_t))) == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (k = 0; k < ndays_h; k++)
+    {
+        // row by row, the masks follow the bucket order of rr_d
+        wd_mask(p_don->rr_d + (size_t)k * N_STATION, N_STATION, p_don->mask + (size_t)k * p_don->n_word);
+    }
+    /* the SSIM statistics of the scored image: rr_d_pre with preprocessing */
+    p_don->stats = (struct ssim_stats *)malloc(sizeof(struct ssim_stats) * (ndays_h + 1));
+    p_don->centered = (double *)malloc(sizeof(double) * N_STATION * ((size_t)ndays_h + 1));
+    if (p_don->stats == NULL || p_don->centered == NULL)
+    {
+        printf("Memory allocation failed in the donor table\n");
+        exit(1);
+    }
+    for (k = 0; k < ndays_h; k++)
+    {
+        SSIM_stats(
+            (p_gp->PREPROCESS != 0 && p_don->rr_d_pre != NULL) ? p_don->rr_d_pre + (size_t)k * N_STATION : p_don->rr_d + (size_t)k * N_STATION,
+            p_gp->NODATA, N_STATION, p_don->stats + k, p_don->centered + (size_t)k * N_STATION);
+    }
+    /* the hourly rr: [ndays_h][N_STATION][24] */
+    p_don->rr_h = p_rrh[0].rr_h;
+    for (k = 0; k < ndays_h; k++)
+    {
+        if (p_rrh[k].rr_h != p_don->rr_h + (size_t)k * N_STATION)
+        {
+            break;
+        }
+    }
+    if (k < ndays_h)
+    {
+        if ((block = (double (*)[24])malloc(sizeof(double) * 24 * N_STATION * ((size_t)ndays_h + 1))) == NULL)
+        {
+            printf("Memory allocation failed in the donor table\n");
+            exit(1);
+        }
+        for (k = 0; k < ndays_h; k++)
+        {
+            memcpy(block + (size_t)k * N_STATION, p_rrh[k].rr_h, sizeof(double) * 24 * N_STATION);
+            p_rrh[k].rr_h = block + (size_t)k * N_STATION;
+        }
+        p_don->rr_h = block;
+        p_don->own = 1;
+    }
+    build_frag(p_don);
+}
+
+void donor_free(
+    struct df_donor *p_don)
+{
+    // the rr_h block taken over from df_rr_h stays with its owner
+    free(p_don->date);
+    free(p_don->class);
+    free(p_don->wd);
+    free(p_don->bucket_from);
+    free(p_don->bucket);
+    free(p_don->row);
+    free(p_don->rr_d);
+    free(p_don->rr_d_pre);
+    free(p_don->mask);
+    free(p_don->stats);
+    free(p_don->centered);
+    free(p_don->frag);
+    if (p_don->own == 1)
+    {
+        free(p_don->rr_h);
+    }
+    memset(p_don, 0, sizeof(struct df_donor));
+}
@@ -0,0 +1,106 @@
+#ifndef FUNC_DONOR
+#define FUNC_DONOR
+
+#include <stddef.h>
+#include <stdint.h>
+#include "def_struct.h"
+
+#define WD_WORDS(N) (((N) + 63) / 64)   // 64-bit words of the wet mask of N stations
+
+void donor_build(
+    struct df_donor *p_don,
+    struct df_rr_h *p_rrh,
+    int ndays_h,
+    struct Para_global *p_gp
+);
+
+void donor_free(
+    struct df_donor *p_don
+);
+
+/* the rows of donor day k (the daily ones are found through row[k]) */
+static inline double *donor_rr_d(
+    const struct df_donor *p_don,
+    int k)
+{
+    return p_don->rr_d + (size_t)p_don->row[k] * p_don->N;
+}
+
+static inline double *donor_rr_d_pre(
+    const struct df_donor *p_don,
+    int k)
+{
+    return p_don->rr_d_pre + (size_t)p_don->row[k] * p_don->N;
+}
+
+static inline double (*donor_rr_h(
+    const struct df_donor *p_don,
+    int k))[24]
+{
+    return p_don->rr_h + (size_t)k * p_don->N;
+}
+
+static inline const uint64_t *donor_mask(
+    const struct df_donor *p_don,
+    int k)
+{
+    return p_don->mask + (size_t)p_don->row[k] * p_don->n_word;
+}
+
+/* the wet mask of a daily rr vector: bit s set when rr[s] > 0 */
+static inline void wd_mask(
+    const double *rr,
+    int N,
+    uint64_t *mask)
+{
+    int s;
+    for (s = 0; s < WD_WORDS(N); s++)
+    {
+        mask[s] = 0;
+    }
+    for (s = 0; s < N; s++)
+    {
+        if (rr[s] > 0.0)
+        {
+            mask[s / 64] |= (uint64_t)1 << (s % 64);
+        }
+    }
+}
+
+/* 1 when any site of the mask is wet (Toggle_WD() of the mask) */
+static inline int wd_any(
+    const uint64_t *mask,
+    int n_word)
+{
+    for (int w = 0; w < n_word; w++)
+    {
+        if (mask[w] != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static inline struct ssim_stats *donor_stats(
+    const struct df_donor *p_don,
+    int k)
+{
+    return p_don->stats + p_don->row[k];
+}
+
+static inline double *donor_centered(
+    const struct df_donor *p_don,
+    int k)
+{
+    return p_don->centered + (size_t)p_don->row[k] * p_don->N;
+}
+
+static inline float (*donor_frag(
+    const struct df_donor *p_don,
+    int k))[24]
+{
+    return p_don->frag + (size_t)k * p_don->N;
+}
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * SUMMARY:      Func_Format.c
+ * USAGE:        format the disaggregated hourly rr into the output text rows
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the output of one day (24 rows) is formatted into a buffer
+ *               and written with a single fwrite(), instead of one fprintf()
+ *               per station-hour:
+ *               - the hourly values are staged hour-major ([24][N_STATION]),
+ *                 so each row reads memory contiguously
+ *               - the date prefix (run, y, m, d) is formatted once per day
+ *               - the values are formatted as integer fixed-point (0.01)
+ * DESCRIP-END.
+ * FUNCTIONS:    buf_reserve(); buf_free(); round_fixed2(); format_fixed2(); format_int2();
+ *               Format_df_rr_h(); Format_df_rr_h_sparse();
+ *
+ * COMMENTS:
+ * format_fixed2() gives exactly the same text as printf("%.2f"):
+ * the fixed-point path is only taken when x * 100 is far enough from a
+ * rounding tie (x.xx5) that the rounding direction is certain; the other
+ * (rare) values, like negative numbers, are formatted by snprintf().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "def_struct.h"
+#include "Func_Format.h"
+
+void buf_reserve(
+    struct out_buf *p_buf,
+    size_t n)
+{
+    // make sure there is space for n more bytes
+    if (p_buf->len + n > p_buf->size)
+    {
+        size_t size = (p_buf->size > 0) ? p_buf->size : 65536;
+        while (p_buf->len + n > size)
+        {
+            size *= 2;
+        }
+        if ((p_buf->data = (char *)realloc(p_buf->data, size)) == NULL)
+        {
+            printf("Memory allocation failed for the output buffer\n");
+            exit(1);
+        }
+        p_buf->size = size;
+    }
+}
+
+void buf_free(
+    struct out_buf *p_buf)
+{
+    free(p_buf->data);
+    free(p_buf->stage);
+    p_buf->data = NULL;
+    p_buf->stage = NULL;
+    p_buf->len = 0;
+    p_buf->size = 0;
+    p_buf->stage_n = 0;
+}
+
+long long round_fixed2(
+    double x)
+{
+    /**************
+     * Description:
+     *      x in units of 0.01, rounded the same as printf("%.2f", x)
+     * Output:
+     *      the rounded integer; -1 if x is negative, too large (>= 1e13) or not a number
+     * ***********/
+    if (x >= 0.0 && x < 1e7 && !signbit(x))
+    {
+        double t = x * 100.0;
+        double t_floor = floor(t);
+        double frac = t - t_floor;
+        if (fabs(frac - 0.5) > 1e-6)
+        {
+            return (long long)t_floor + (frac > 0.5 ? 1 : 0);
+        }
+    }
+    if (x >= 0.0 && x < 1e13 && !signbit(x))
+    {
+        /* rounding tie or huge: take the digits of printf() */
+        char temp[64];
+        long long n = 0;
+        int i, len = snprintf(temp, sizeof(temp), "%.2f", x);
+        for (i = 0; i < len; i++)
+        {
+            if (temp[i] != '.')
+            {
+                n = n * 10 + (temp[i] - '0');
+            }
+        }
+        return n;
+    }
+    return -1;
+}
+
+int format_fixed2(
+    double x,
+    char *s)
+{
+    /**************
+     * Description:
+     *      write x into s, the same as sprintf(s, "%.2f", x) (not null-terminated)
+     * Output:
+     *      the number of characters written
+     * ***********/
+    if (x >= 0.0 && x < 1e7 && !signbit(x))
+    {
+        double t = x * 100.0;
+        double t_floor = floor(t);
+        double frac = t - t_floor;
+        if (fabs(frac - 0.5) > 1e-6)
+        {
+            uint64_t n = (uint64_t)t_floor + (frac > 0.5 ? 1 : 0);
+            return format_int2((long long)n, s);
+        }
+    }
+    /* rounding tie, negative, huge or not a number */
+    char temp[400];
+    int len = snprintf(temp, sizeof(temp), "%.2f", x);
+    memcpy(s, temp, len);
+    return len;
+}
+
+int format_int2(
+    long long n,
+    char *s)
+{
+    /**************
+     * Description:
+     *      write the fixed-point n (units of 0.01, n >= 0) into s as "%.2f" text (not null-terminated)
+     * Output:
+     *      the number of characters written
+     * ***********/
+    long long n_int = n / 100;
+    int n_dec = (int)(n % 100);
+    char digits[24];
+    int k = 0, len = 0;
+    do
+    {
+        digits[k++] = (char)('0' + n_int % 10);
+        n_int /= 10;
+    } while (n_int > 0);
+    while (k > 0)
+    {
+        s[len++] = digits[--k];
+    }
+    s[len++] = '.';
+    s[len++] = (char)('0' + n_dec / 10);
+    s[len++] = (char)('0' + n_dec % 10);
+    return len;
+}
+
+void Format_df_rr_h(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf)
+{
+    /**************
+     * Description:
+     *      append the 24 output rows of one day (and one run) to the buffer;
+     *      the same layout as written by fprintf() before:
+     *      [run,]y,m,d,h,rr_1,...,rr_N (%.2f)
+     * Parameters:
+     *      p_out: the disaggregated hourly rr of the day
+     *      p_gp: global parameters (N_STATION, RUN)
+     *      run: the index of the simulation run, from 1
+     *      p_buf: the output buffer
+     * ***********/
+    int j, h, N, len_prefix, len;
+    char prefix[64];
+    double *p_stage;
+    N = p_gp->N_STATION;
+
+    /* hour-major staging of the [N_STATION][24] values */
+    if (p_buf->stage_n != N)
+    {
+        p_buf->stage = (double *)realloc(p_buf->stage, sizeof(double) * 24 * N);
+        p_buf->stage_n = N;
+    }
+    for (j = 0; j < N; j++)
+    {
+        for (h = 0; h < 24; h++)
+        {
+            p_buf->stage[h * N + j] = p_out->rr_h[j][h];
+        }
+    }
+
+    /* the date prefix of the rows of this day */
+    if (p_gp->RUN == 1)
+    {
+        // only one run (simulation)
+        len_prefix = snprintf(prefix, sizeof(prefix), "%d,%d,%d,", p_out->date.y, p_out->date.m, p_out->date.d);
+    }
+    else if (p_gp->RUN > 1)
+    {
+        // multiple simulations (realizations)
+        len_prefix = snprintf(prefix, sizeof(prefix), "%d,%d,%d,%d,", run, p_out->date.y, p_out->date.m, p_out->date.d);
+    }
+    else
+    {
+        len_prefix = 0;
+    }
+
+    for (h = 0; h < 24; h++)
+    {
+        buf_reserve(p_buf, len_prefix + 4);
+        memcpy(p_buf->data + p_buf->len, prefix, len_prefix);
+        p_buf->len += len_prefix;
+        if (h >= 10)
+        {
+            p_buf->data[p_buf->len++] = (char)('0' + h / 10);
+        }
+        p_buf->data[p_buf->len++] = (char)('0' + h % 10);
+
+        p_stage = p_buf->stage + h * N;
+        for (j = 0; j < N; j++)
+        {
+            buf_reserve(p_buf, 402); // the longest "%.2f" text, and ",", "\n"
+            p_buf->data[p_buf->len++] = ',';
+            len = format_fixed2(p_stage[j], p_buf->data + p_buf->len);
+            p_buf->len += len;
+        }
+        p_buf->data[p_buf->len++] = '\n'; // "\n" (newline) after one row
+    }
+}
+
+int Format_df_rr_h_sparse(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf)
+{
+    /**************
+     * Description:
+     *      append the sparse output row of one day and one run to the buffer:
+     *      run,y,m,d,n,station,hour,rr,...
+     *      only the n values which are not written as "0.00" are stored,
+     *      as triplets of station (from 1), hour (0-23) and rr (%.2f);
+     *      nothing is appended when all the values are "0.00"
+     * Parameters:
+     *      p_out: the disaggregated hourly rr of the day
+     *      p_gp: global parameters (N_STATION)
+     *      run: the index of the simulation run, from 1
+     *      p_buf: the output buffer
+     * Output:
+     *      n, the number of triplets
+     * ***********/
+    int j, h, n, N;
+    double x;
+    N = p_gp->N_STATION;
+    n = 0;
+    for (j = 0; j < N; j++)
+    {
+        for (h = 0; h < 24; h++)
+        {
+            n += (round_fixed2(p_out->rr_h[j][h]) != 0); // not written as "0.00"
+        }
+    }
+    if (n == 0)
+    {
+        return 0;
+    }
+    buf_reserve(p_buf, 80);
+    p_buf->len += sprintf(p_buf->data + p_buf->len, "%d,%d,%d,%d,%d", run, p_out->date.y, p_out->date.m, p_out->date.d, n);
+    for (j = 0; j < N; j++)
+    {
+        for (h = 0; h < 24; h++)
+        {
+            x = p_out->rr_h[j][h];
+            if (round_fixed2(x) != 0)
+            {
+                buf_reserve(p_buf, 440); // ",station,hour," and the longest "%.2f" text
+                p_buf->len += sprintf(p_buf->data + p_buf->len, ",%d,%d,", j + 1, h);
+                p_buf->len += format_fixed2(x, p_buf->data + p_buf->len);
+            }
+        }
+    }
+    p_buf->data[p_buf->len++] = '\n';
+    return n;
+}
@@ -0,0 +1,56 @@
+#ifndef FUNC_FORMAT
+#define FUNC_FORMAT
+
+#include <stddef.h>
+
+struct out_buf
+{
+    /*
+     * growable character buffer for the formatted output,
+     * together with the hour-major staging of one day
+     */
+    char *data;
+    size_t len;     // bytes in use
+    size_t size;    // bytes allocated
+    double *stage;  // [24][N_STATION]
+    int stage_n;    // N_STATION the staging is allocated for
+};
+
+void buf_reserve(
+    struct out_buf *p_buf,
+    size_t n
+);
+
+void buf_free(
+    struct out_buf *p_buf
+);
+
+long long round_fixed2(
+    double x
+);
+
+int format_fixed2(
+    double x,
+    char *s
+);
+
+int format_int2(
+    long long n,
+    char *s
+);
+
+void Format_df_rr_h(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf
+);
+
+int Format_df_rr_h_sparse(
+    struct df_rr_h *p_out,
+    struct Para_global *p_gp,
+    int run,
+    struct out_buf *p_buf
+);
+
+#endif
@@ -5,6 +5,7 @@
 #include <math.h>
 #include "def_struct.h"
 #include "Func_Fragments.h"
+#include "Func_Donor.h"
 
 int Toggle_WD(
     int N_STATION,
@@ -27,106 +28,70 @@ int Toggle_WD(
     return WD;
 }
 
+static int wd_match(
+    const uint64_t *mask_t,
+    const uint64_t *mask_c,
+    int n_word,
+    int WD)
+{
+    /***********
+     * wet-dry status matching of the target and a candidate, word by word
+     * - WD == 1 (flexible): each wet site of the target is wet in the candidate
+     * - WD == 0 (strict): the wet sites are identical
+     ***********/
+    uint64_t diff = 0;
+    for (int w = 0; w < n_word; w++)
+    {
+        diff |= (WD == 1) ? (mask_t[w] & ~mask_c[w]) : (mask_t[w] ^ mask_c[w]);
+    }
+    return diff == 0;
+}
+
 int Toggle_CONTINUITY(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_d *p_rrd,
     struct Para_global *p_gp,
-    int ndays_h,
     int pool_cans[])
 {
     /*****************
      * Description:
      *      wet-dry status continuity matching check
      * Parameters:
-     *      p_rrh: pointing to df_rr_hourly struct array (all the hourly rr observations);
+     *      p_don: the donor table (all the hourly rr observations);
      *      p_rrd: pointing to target day (to be disaggregated);
      *      p_gp: pointing to global parameter struct;
-     *      ndays_h: number of days in hourly rr data;
      *      pool_cans: the pool of candidate index;
      * Output:
      *      - the number of candidates (pool size)
      *      - bring back the pool_cans array
      * ***************/
-    int skip, match;                          // match: whether wet-dry status match; 1: match; 0: not match
+    int skip;
     int n_cans = 0;                           // number of candidates fullfilling the CONTINUITY criteria (output)
     skip = (int)((p_gp->CONTINUITY - 1) / 2); // p_gp->CONTINUITY == 1: skip=0; p_gp->CONTINUITY == 3: skip=1
-    int WD;
+    int WD = p_gp->WD;
     /*****
      * WD:
      * - 1: flexiable
      * - 0: strict, perfect match in wet-dry status
      * - -1: no requirement, as long as the candidate day is also wet
      * ***/
-    if (WD == 1)
-    {
-        for (int k = skip; k < ndays_h - skip; k++)
-        {
-            // iterate each day in hourly observations
-            match = 1;
-            for (int s = 0; s < p_gp->N_STATION; s++)
-            {
-                /* flexible wet-dry status matching*/
-                if (p_rrd->p_rr[s] > FloatZero && (p_rrh + k)->rr_d[s] <= FloatZero)
-                {
-                    match = 0;
-                    break;
-                }
-            }
-
-            if (match == 1)
-            {
-                *(pool_cans + n_cans) = k;
-                n_cans++;
-            }
-        }
-    }
-    else if (WD == 0)
+    uint64_t mask_t[WD_WORDS(p_gp->N_STATION)]; // the wet sites of the target day
+    wd_mask(p_rrd->p_rr, p_gp->N_STATION, mask_t);
+    for (int k = skip; k < p_don->ndays - skip; k++)
     {
-        // strict; wet == wet or dry == dry for each site
-        for (int k = skip; k < ndays_h - skip; k++)
+        // iterate each day in hourly observations
+        if (WD == -1 ? p_don->wd[k] == 1 : wd_match(mask_t, donor_mask(p_don, k), p_don->n_word, WD) == 1)
         {
-            // iterate each day in hourly observations
-            match = 1;
-            for (int s = 0; s < p_gp->N_STATION; s++)
-            {
-                if (
-                    (p_rrd->p_rr[s] > FloatZero && (p_rrh + k)->rr_d[s] <= FloatZero) || 
-                    (p_rrd->p_rr[s] <= FloatZero && (p_rrh + k)->rr_d[s] > FloatZero)
-                    )
-                {
-                    match = 0;
-                    break;
-                }
-            }
-
-            if (match == 1)
-            {
-                *(pool_cans + n_cans) = k;
-                n_cans++;
-            }
-        }
-    }
-    else if (WD == -1)
-    {
-        /********
-         * as long as it is a wet day; don't care the wet-dry match 
-         * ****/
-        for (int k = skip; k < ndays_h - skip; k++)
-        {
-            if (Toggle_WD(p_gp->N_STATION, (p_rrh + k)->rr_d) == 1)
-            {
-                *(pool_cans + n_cans) = k;
-                n_cans++;
-            }
+            *(pool_cans + n_cans) = k;
+            n_cans++;
         }
     }
     return n_cans;
 }
 
 int Filter_WD_multisite(
-    struct df_rr_h *p_rrh,
-    double *p_rr_t,
-    int N_STATION,
+    struct df_donor *p_don,
+    const uint64_t *mask_t,
     int n_can,
     int pool_cans[],
     int pool_cans_final[],
@@ -134,56 +99,19 @@ int Filter_WD_multisite(
 )
 {
     /*****
+     * p_don: the donor table; the wet masks of the candidates are rows of p_don->mask
+     * mask_t: the wet mask of the target (the sites still to disaggregate)
      * WD:
      * - 1: flexiable
      * - 0: strict, perfect match in wet-dry status
      * - -1: no requirement, as long as the candidate day is also wet
      * ***/
-    int match = 0;
     int index = 0;
-    if (WD == 1)
+    if (WD == 1 || WD == 0)
     {
         for (int k = 0; k < n_can; k++)
         {
-            // iterate each day in hourly observations
-            match = 1;
-            for (int s = 0; s < N_STATION; s++)
-            {
-                /* flexible wet-dry status matching*/
-                if (*(p_rr_t + s) > 0 && (p_rrh + pool_cans[k])->rr_d[s] <= 0)
-                {
-                    match = 0;
-                    break;
-                }
-            }
-
-            if (match == 1)
-            {
-                *(pool_cans_final + index) = pool_cans[k];
-                index++;
-            }
-        }
-    }
-    else if (WD == 0)
-    {
-        // strict; wet == wet or dry == dry for each site
-        for (int k = 0; k < n_can; k++)
-        {
-            // iterate each day in hourly observations
-            match = 1;
-            for (int s = 0; s < N_STATION; s++)
-            {
-                if (
-                    (*(p_rr_t + s) > 0 && (p_rrh + pool_cans[k])->rr_d[s] <= 0) || 
-                    (*(p_rr_t + s) <= 0 && (p_rrh + pool_cans[k])->rr_d[s] > 0)
-                    )
-                {
-                    match = 0;
-                    break;
-                }
-            }
-
-            if (match == 1)
+            if (wd_match(mask_t, donor_mask(p_don, pool_cans[k]), p_don->n_word, WD) == 1)
             {
                 *(pool_cans_final + index) = pool_cans[k];
                 index++;
@@ -206,46 +134,34 @@ int Filter_WD_multisite(
 
 
 int Filter_WD_Class(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_d *p_rrd,
     int id_target,
-    int ndays_h,
-    int pool_cans[]
+    int **pool_cans
 )
 {
     /**************************
      * filter the candidate pools based on the following criteria:
      * - class: either cp type or seasonality(12 months or 2 seasons)
-     * - continuity: the wet-dry status before and after the target and candidate day
+     * - wet-dry status of the candidate identical to that of the target day
      * PS: in SSIM calculation, empty map could bring error or bias
+     * the candidates are the bucket (class, wd) of the target in p_don,
+     * built once in donor_build(); *pool_cans points into p_don->bucket
+     * (the days in increasing order), not to be modified
      * ***********************/
-    int index = 0;
-    int CLASS_candidate, CLASS_target;
-    int wd_target, wd_candidate;
-    CLASS_target = (p_rrd + id_target)->class;
-    wd_target = (p_rrd + id_target)->wd;
-    
-    for (size_t i = 0; i < ndays_h; i++)
+    int b;
+    b = (p_rrd + id_target)->class * 2 + (p_rrd + id_target)->wd;
+    if ((p_rrd + id_target)->class < 0 || b >= p_don->n_bucket)
     {
-        /*********
-         * criteria:
-         * - class: cp type and seasonality
-         * - the days before and after the target day exist, if CONTUNITY > 1
-         * - wet-dry status of the days before and after the target day should be identical to those of the candidate
-         * ******/
-        CLASS_candidate = (p_rrh + i)->class; // the class of the candidate day
-        wd_candidate = (p_rrh + i)->wd;
-        if (CLASS_candidate == CLASS_target && wd_candidate == wd_target) 
-        {
-            pool_cans[index] = i;
-            index += 1;
-        }
+        *pool_cans = NULL;
+        return 0; // no donor day of this class
     }
-    return(index);  // the number of candidates after filtering 
+    *pool_cans = p_don->bucket + p_don->bucket_from[b];
+    return p_don->bucket_from[b + 1] - p_don->bucket_from[b]; // the number of candidates after filtering
 }
 
 void Fragment_assign(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_h *p_out,
     struct Para_global *p_gp,
     struct df_coor *p_coor,
@@ -255,7 +171,7 @@ void Fragment_assign(
      * Description:
      *      disaggregate the target day rainfall into hourly scale based on the selected fragments
      * Parameters:
-     *      p_rrh: pointing to the hourly obs rr structure array
+     *      p_don: the donor table of the hourly obs rr
      *      p_out: pointing to the disaggregated hourly rr results struct (to output)
      *      p_gp: global parameters struct
      *      fragment: the index of p_rrh struct after filtering and resampling
@@ -263,11 +179,14 @@ void Fragment_assign(
      *      p_out
      * *******/
     int j, h;
+    double *rr_d = donor_rr_d(p_don, fragment);
+    float (*frag)[24] = donor_frag(p_don, fragment);
     for (j = 0; j < p_gp->N_STATION; j++)
     {
         if (p_out->rr_d[j] > 0.0)
         {
-            if ((p_rrh + fragment)->rr_d[j] <= 0.0)
+            int id = j;
+            if (rr_d[j] <= 0.0)
             {
                 /********
                  * the rain site in the target day is wet while in candidate day it is dry,
@@ -283,14 +202,13 @@ void Fragment_assign(
                 /*********
                  * borrow fragments from nearest rainy (wet) neighbour
                  */
-                int id;
                 int index = 0;
                 int wd = 0;
                 while (wd == 0 && index < p_gp->N_STATION - 1)
                 {
                     // p_gp->N_STATION - 1: number of neighbours
                     id = *((p_coor + j)->neighbors + index);
-                    if ((p_rrh + fragment)->rr_d[id] > 0.0)
+                    if (rr_d[id] > 0.0)
                     {
                         // the neighbour is wet
                         wd = 1;
@@ -300,17 +218,10 @@ void Fragment_assign(
                         index += 1;
                     }
                 }
-                for (h = 0; h < 24; h++)
-                {
-                    p_out->rr_h[j][h] = p_out->rr_d[j] * (p_rrh + fragment)->rr_h[id][h] / (p_rrh + fragment)->rr_d[id];
-                }
             }
-            else
+            for (h = 0; h < 24; h++)
             {
-                for (h = 0; h < 24; h++)
-                {
-                    p_out->rr_h[j][h] = p_out->rr_d[j] * (p_rrh + fragment)->rr_h[j][h] / (p_rrh + fragment)->rr_d[j];
-                }
+                p_out->rr_h[j][h] = p_out->rr_d[j] * frag[id][h];
             }
         }
         else
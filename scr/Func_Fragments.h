@@ -2,6 +2,7 @@
 #ifndef FUNC_FRAGMENTS
 #define FUNC_FRAGMENTS
 
+#include <stdint.h>
 
 int Toggle_WD(
     int N_STATION,
@@ -9,17 +10,15 @@ int Toggle_WD(
 );
 
 int Toggle_CONTINUITY(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_d *p_rrd,
     struct Para_global *p_gp,
-    int ndays_h,
     int pool_cans[]
 );
 
 int Filter_WD_multisite(
-    struct df_rr_h *p_rrh,
-    double *p_rr_t,
-    int N_STATION,
+    struct df_donor *p_don,
+    const uint64_t *mask_t,
     int n_can,
     int pool_cans[],
     int pool_cans_final[],
@@ -27,16 +26,15 @@ int Filter_WD_multisite(
 );
 
 int Filter_WD_Class(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_d *p_rrd,
     int id_target,
-    int ndays_h,
-    int pool_cans[]
+    int **pool_cans
 );
 
 
 void Fragment_assign(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_h *p_out,
     struct Para_global *p_gp,
     struct df_coor *p_coor,
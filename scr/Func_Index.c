@@ -0,0 +1,248 @@
+/*
+ * SUMMARY:      Func_Index.c
+ * USAGE:        byte-offset index of the months of a daily data file
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  with START_DATE and (or) END_DATE only the days of FP_DAILY in
+ *               this range are imported and disaggregated; the offset of the
+ *               first row of each month is kept in the sidecar file FP_DAILY.idx
+ *               (like rr_obs_daily.csv.idx), so that the loaders begin reading
+ *               at the month of START_DATE instead of the beginning of the file.
+ *               the index is built by the first run with a date range, and
+ *               built again when FP_DAILY has been modified since.
+ * DESCRIP-END.
+ * FUNCTIONS:    date_index_window(); stream_select();
+ *
+ * COMMENTS:
+ * index file: a header row #KNNMOF_INDEX,version,size,mtime (of FP_DAILY),
+ * then one row yyyy,mm,offset per month.
+ * without index (gzip-compressed file, standard input, rows not in
+ * chronological order, or the index cannot be written) the rows are read
+ * from the beginning and filtered by date.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "Func_mmap.h"
+#include "Func_Stream.h"
+#include "Func_Index.h"
+
+#define INDEX_VERSION 1
+
+struct date_index
+{
+    /* the months of a data file, in chronological order */
+    int n;              // number of months
+    int *ym;            // yyyymm
+    long long *offset;  // the first row of the month, bytes from the beginning of the file
+    long long size;     // size of the file in bytes
+};
+
+static void index_push(
+    struct date_index *p_idx,
+    int *p_alloc,
+    int ym,
+    long long offset)
+{
+    if (p_idx->n == *p_alloc)
+    {
+        *p_alloc = (*p_alloc == 0) ? 1024 : *p_alloc * 2;
+        p_idx->ym = (int *)realloc(p_idx->ym, sizeof(int) * *p_alloc);
+        p_idx->offset = (long long *)realloc(p_idx->offset, sizeof(long long) * *p_alloc);
+        if (p_idx->ym == NULL || p_idx->offset == NULL)
+        {
+            printf("Memory allocation failed in indexing the data file\n");
+            exit(1);
+        }
+    }
+    p_idx->ym[p_idx->n] = ym;
+    p_idx->offset[p_idx->n] = offset;
+    p_idx->n++;
+}
+
+static int index_load(
+    char fname_idx[],
+    long long size,
+    long long mtime,
+    struct date_index *p_idx)
+{
+    /**************
+     * Description:
+     *      read the index file, when it is up to date with the data file
+     * Output:
+     *      0: loaded; -1: no (valid) index file
+     * ***********/
+    FILE *fp;
+    char row[128];
+    int version, y, m, n_alloc = 0;
+    long long src_size, src_mtime, offset;
+    if ((fp = fopen(fname_idx, "r")) == NULL)
+    {
+        return -1;
+    }
+    if (
+        fgets(row, sizeof(row), fp) == NULL ||
+        sscanf(row, "#KNNMOF_INDEX,%d,%lld,%lld", &version, &src_size, &src_mtime) != 3 ||
+        version != INDEX_VERSION || src_size != size || src_mtime != mtime)
+    {
+        fclose(fp);
+        return -1;
+    }
+    while (fgets(row, sizeof(row), fp) != NULL)
+    {
+        if (sscanf(row, "%d,%d,%lld", &y, &m, &offset) == 3)
+        {
+            index_push(p_idx, &n_alloc, y * 100 + m, offset);
+        }
+    }
+    fclose(fp);
+    p_idx->size = size;
+    return 0;
+}
+
+static int index_build(
+    char fname[],
+    char fname_idx[],
+    long long size,
+    long long mtime,
+    struct date_index *p_idx)
+{
+    /**************
+     * Description:
+     *      scan the data file for the first row of each month, and write the index file
+     * Output:
+     *      0: built; -1: the file cannot be read, or the rows are not chronological
+     * ***********/
+    struct file_map fm;
+    FILE *fp;
+    char *p, *q, *end;
+    int y, m, ym, k, n_alloc = 0;
+    if (map_file(fname, &fm) != 0)
+    {
+        return -1;
+    }
+    end = fm.data + fm.size;
+    for (p = fm.data; p < end; p = next_line(p, end))
+    {
+        if (*p == '\n' || *p == '\r')
+        {
+            continue; // empty row
+        }
+        q = p;
+        y = parse_int(&q, end);
+        m = parse_int(&q, end);
+        ym = y * 100 + m;
+        if (p_idx->n > 0 && ym < p_idx->ym[p_idx->n - 1])
+        {
+            unmap_file(&fm);
+            p_idx->n = 0;
+            return -1;
+        }
+        if (p_idx->n == 0 || ym != p_idx->ym[p_idx->n - 1])
+        {
+            index_push(p_idx, &n_alloc, ym, (long long)(p - fm.data));
+        }
+    }
+    unmap_file(&fm);
+    p_idx->size = size;
+    /* the index is only an acceleration: a read-only directory is no error */
+    if ((fp = fopen(fname_idx, "w")) != NULL)
+    {
+        fprintf(fp, "#KNNMOF_INDEX,%d,%lld,%lld\n", INDEX_VERSION, size, mtime);
+        for (k = 0; k < p_idx->n; k++)
+        {
+            fprintf(fp, "%d,%d,%lld\n", p_idx->ym[k] / 100, p_idx->ym[k] % 100, p_idx->offset[k]);
+        }
+        fclose(fp);
+    }
+    return 0;
+}
+
+int date_index_window(
+    char fname[],
+    int key_from,
+    int key_to,
+    long long *p_from,
+    long long *p_to)
+{
+    /**************
+     * Description:
+     *      the bytes of a daily data file which hold the rows of a date range,
+     *      whole months: the rows of the first and last month out of the
+     *      range are still to be filtered by the caller
+     * Parameters:
+     *      fname: the data file (FP_DAILY); the index is fname.idx
+     *      key_from, key_to: the date range, yyyymmdd
+     *      p_from, p_to: the window [*p_from, *p_to) in bytes
+     * Output:
+     *      0: the window is found; -1: no index, the whole file is to be read
+     * ***********/
+    struct date_index idx = {0, NULL, NULL, 0};
+    struct stat st;
+    char fname_idx[220];
+    int k;
+    if (is_gz(fname) || is_std(fname) || stat(fname, &st) != 0)
+    {
+        return -1;
+    }
+    sprintf(fname_idx, "%s.idx", fname);
+    if (
+        index_load(fname_idx, (long long)st.st_size, (long long)st.st_mtime, &idx) != 0 &&
+        index_build(fname, fname_idx, (long long)st.st_size, (long long)st.st_mtime, &idx) != 0)
+    {
+        return -1;
+    }
+    *p_from = idx.size;
+    *p_to = idx.size;
+    for (k = idx.n - 1; k >= 0 && idx.ym[k] >= key_from / 100; k--)
+    {
+        *p_from = idx.offset[k];
+    }
+    for (k = idx.n - 1; k >= 0 && idx.ym[k] > key_to / 100; k--)
+    {
+        *p_to = idx.offset[k];
+    }
+    free(idx.ym);
+    free(idx.offset);
+    return 0;
+}
+
+void stream_select(
+    struct stream_in *p_in,
+    char fname[],
+    int key_from,
+    int key_to)
+{
+    /**************
+     * Description:
+     *      restrict an opened daily data file to the rows of a date range:
+     *      the file is positioned at the month of key_from (index), and
+     *      import_dfrr_d_chunk() skips the rows out of the range; without
+     *      index the whole file is read and filtered
+     * Parameters:
+     *      p_in: the daily data file, opened by stream_open_in()
+     *      key_from, key_to: the date range, yyyymmdd
+     * ***********/
+    long long off_from, off_to;
+    p_in->key_from = key_from;
+    p_in->key_to = key_to;
+    p_in->past = 0;
+    p_in->ordered = 0;
+    if ((key_from <= 0 && key_to >= DATE_KEY_MAX) || p_in->fp == NULL || p_in->fp == stdin)
+    {
+        return;
+    }
+    if (date_index_window(fname, key_from, key_to, &off_from, &off_to) == 0)
+    {
+        /* the index confirms the months are chronological: the read may stop after key_to */
+        p_in->ordered = 1;
+        if (key_from > 0 && off_from > 0)
+        {
+            fseek(p_in->fp, (long)off_from, SEEK_SET);
+        }
+    }
+}
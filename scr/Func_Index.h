@@ -0,0 +1,23 @@
+#ifndef FUNC_INDEX
+#define FUNC_INDEX
+
+#include "Func_Stream.h"
+
+#define DATE_KEY_MAX 99999999 // the open end of a date range (yyyymmdd)
+
+int date_index_window(
+    char fname[],
+    int key_from,
+    int key_to,
+    long long *p_from,
+    long long *p_to
+);
+
+void stream_select(
+    struct stream_in *p_in,
+    char fname[],
+    int key_from,
+    int key_to
+);
+
+#endif
@@ -0,0 +1,450 @@
+/*
+ * SUMMARY:      Func_Ingest.c
+ * USAGE:        import the daily, hourly and cp data files on N_THREAD threads
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the data file is mapped into memory (Func_mmap.c) and split
+ *               into N_THREAD chunks at row boundaries:
+ *               - pass 1: each thread counts the (non-empty) rows of its chunk;
+ *                 the running sum gives the index of the first row of each chunk
+ *               - the struct array is allocated at its exact size
+ *               - pass 2: each thread parses its rows into their final place,
+ *                 so the result is the same as (and in the order of) the
+ *                 sequential import_dfrr_d(), import_dfrr_h() and import_df_cp()
+ *               hourly data: the row index decides the day (row / 24), so a day
+ *               may be split across two chunks; the daily rr of the hourly obs
+ *               are aggregated afterwards in pass 3 (days split among threads).
+ * DESCRIP-END.
+ * FUNCTIONS:    import_dfrr_d_parallel(); import_dfrr_h_parallel(); import_df_cp_parallel();
+ *
+ * COMMENTS:
+ * the rr values of all the days are kept in one allocation (per struct array),
+ * which the rows point into.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "def_struct.h"
+#include "Func_mmap.h"
+#include "Func_Index.h"
+#include "Func_Ingest.h"
+
+#define INGEST_DAILY 1
+#define INGEST_HOURLY 2
+#define INGEST_CP 3
+
+struct ingest_task
+{
+    /* one chunk of the data file, handled by one thread */
+    int kind;           // INGEST_DAILY, INGEST_HOURLY or INGEST_CP
+    int pass;           // 1: count the rows; 2: parse the rows; 3: aggregate (hourly)
+    char *from;         // the first row of the chunk
+    char *to;           // the end of the chunk
+    long long n_row;    // pass 1: the number of non-empty rows in the chunk
+    long long row0;     // pass 2: the index of the first row of the chunk in the file
+    long long n_keep;   // pass 2: rows with index >= n_keep are not imported (hourly: incomplete day)
+    int day_from;       // pass 3: the days to aggregate
+    int day_to;
+    int key_from;       // daily: the date range (yyyymmdd) of the rows to import
+    int key_to;
+    int N_STATION;
+    char *fname;
+    void *p_df;         // the struct array
+};
+
+static char *row_end_of(
+    char *p,
+    char *end)
+{
+    char *q = memchr(p, '\n', (size_t)(end - p));
+    return (q == NULL) ? end : q;
+}
+
+static int ingest_in_range(
+    struct ingest_task *p_task,
+    char *p,
+    char *row_end)
+{
+    // whether the date of a daily row is in the range START_DATE - END_DATE
+    int key;
+    if (p_task->kind != INGEST_DAILY || (p_task->key_from <= 0 && p_task->key_to >= DATE_KEY_MAX))
+    {
+        return 1;
+    }
+    key = parse_int(&p, row_end) * 10000;
+    key += parse_int(&p, row_end) * 100;
+    key += parse_int(&p, row_end);
+    return (key >= p_task->key_from && key <= p_task->key_to);
+}
+
+static void ingest_row(
+    struct ingest_task *p_task,
+    char *p,
+    char *row_end,
+    long long i)
+{
+    // parse the row with index i (in the file) into its place in the struct array
+    int j, h;
+    if (p_task->kind == INGEST_DAILY)
+    {
+        struct df_rr_d *p_df = (struct df_rr_d *)p_task->p_df + i;
+        p_df->date.y = parse_int(&p, row_end);
+        p_df->date.m = parse_int(&p, row_end);
+        p_df->date.d = parse_int(&p, row_end);
+        for (j = 0; j < p_task->N_STATION; j++)
+        {
+            if (p >= row_end)
+            {
+                printf("Missing values in row %lld of daily rr data file: %s\n", i + 1, p_task->fname);
+                exit(1);
+            }
+            p_df->p_rr[j] = parse_double(&p, row_end);
+        }
+    }
+    else if (p_task->kind == INGEST_HOURLY)
+    {
+        struct df_rr_h *p_df = (struct df_rr_h *)p_task->p_df + i / 24;
+        if (i % 24 == 0)
+        {
+            p_df->date.y = parse_int(&p, row_end);
+            p_df->date.m = parse_int(&p, row_end);
+            p_df->date.d = parse_int(&p, row_end);
+        }
+        else
+        {
+            // just skip the date (y, m, d)
+            skip_field(&p, row_end);
+            skip_field(&p, row_end);
+            skip_field(&p, row_end);
+        }
+        h = parse_int(&p, row_end);
+        if (h < 0 || h > 23)
+        {
+            printf("Invalid hour %d in row %lld of hourly rr data file: %s\n", h, i + 1, p_task->fname);
+            exit(1);
+        }
+        for (j = 0; j < p_task->N_STATION; j++)
+        {
+            if (p >= row_end)
+            {
+                printf("Missing values in row %lld of hourly rr data file: %s\n", i + 1, p_task->fname);
+                exit(1);
+            }
+            p_df->rr_h[j][h] = parse_double(&p, row_end);
+        }
+    }
+    else
+    {
+        struct df_cp *p_df = (struct df_cp *)p_task->p_df + i;
+        p_df->date.y = parse_int(&p, row_end);
+        p_df->date.m = parse_int(&p, row_end);
+        p_df->date.d = parse_int(&p, row_end);
+        p_df->cp = parse_int(&p, row_end);
+    }
+}
+
+static void *ingest_thread(
+    void *arg)
+{
+    struct ingest_task *p_task = (struct ingest_task *)arg;
+    char *p, *row_end;
+    long long i;
+    int d, j, h;
+    if (p_task->pass == 3)
+    {
+        /* aggregate the hourly rr into daily scale */
+        struct df_rr_h *p_df;
+        for (d = p_task->day_from; d < p_task->day_to; d++)
+        {
+            p_df = (struct df_rr_h *)p_task->p_df + d;
+            for (j = 0; j < p_task->N_STATION; j++)
+            {
+                p_df->rr_d[j] = 0.0;
+                for (h = 0; h < 24; h++)
+                {
+                    p_df->rr_d[j] += p_df->rr_h[j][h];
+                }
+            }
+        }
+        return NULL;
+    }
+    i = p_task->row0;
+    p_task->n_row = 0;
+    for (p = p_task->from; p < p_task->to; p = row_end + 1)
+    {
+        row_end = row_end_of(p, p_task->to);
+        if (row_end - p <= 1)
+        {
+            continue; // empty row (like the last one)
+        }
+        if (ingest_in_range(p_task, p, row_end) == 0)
+        {
+            continue;
+        }
+        if (p_task->pass == 1)
+        {
+            p_task->n_row++;
+        }
+        else if (i < p_task->n_keep)
+        {
+            ingest_row(p_task, p, row_end, i);
+            i++;
+        }
+    }
+    return NULL;
+}
+
+static void ingest_run(
+    struct ingest_task *tasks,
+    int n_task)
+{
+    // run the tasks in parallel: the first on the calling thread
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * n_task);
+    int k;
+    for (k = 1; k < n_task; k++)
+    {
+        if (pthread_create(threads + k, NULL, ingest_thread, tasks + k) != 0)
+        {
+            printf("Program terminated: cannot start the import threads\n");
+            exit(1);
+        }
+    }
+    ingest_thread(tasks);
+    for (k = 1; k < n_task; k++)
+    {
+        pthread_join(threads[k], NULL);
+    }
+    free(threads);
+}
+
+static long long ingest_split(
+    struct file_map *p_fm,
+    int kind,
+    int N_STATION,
+    int N_THREAD,
+    char fname[],
+    int key_from,
+    int key_to,
+    struct ingest_task **p_tasks)
+{
+    /**************
+     * Description:
+     *      split the mapped file into N_THREAD chunks at row boundaries and
+     *      count the rows (pass 1); daily: only the rows in the date range
+     *      key_from - key_to (yyyymmdd)
+     * Output:
+     *      the number of non-empty rows in the file
+     * ***********/
+    struct ingest_task *tasks;
+    char *end = p_fm->data + p_fm->size;
+    char *p;
+    long long n_row = 0;
+    int k;
+    tasks = (struct ingest_task *)calloc(N_THREAD, sizeof(struct ingest_task));
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].kind = kind;
+        tasks[k].pass = 1;
+        tasks[k].N_STATION = N_STATION;
+        tasks[k].fname = fname;
+        tasks[k].key_from = key_from;
+        tasks[k].key_to = key_to;
+        /* a chunk begins at the first row starting at or after its share of bytes */
+        p = p_fm->data + p_fm->size / N_THREAD * k;
+        if (k > 0 && p > p_fm->data && p[-1] != '\n')
+        {
+            p = next_line(p, end);
+        }
+        tasks[k].from = p;
+    }
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].to = (k + 1 < N_THREAD) ? tasks[k + 1].from : end;
+        if (tasks[k].to < tasks[k].from)
+        {
+            tasks[k].to = tasks[k].from;
+        }
+    }
+    ingest_run(tasks, N_THREAD);
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].row0 = n_row;
+        tasks[k].pass = 2;
+        n_row += tasks[k].n_row;
+    }
+    *p_tasks = tasks;
+    return n_row;
+}
+
+int import_dfrr_d_parallel(
+    char FP_daily[],
+    int N_STATION,
+    int N_THREAD,
+    int key_from,
+    int key_to,
+    struct df_rr_d **p_rr_d)
+{
+    /**************
+     * Main:
+     *  import daily rainfall data (tobe disaggregated) into memory, on N_THREAD threads
+     * Parameters:
+     *  FP_daily: a string, storing the file path and name of daily rr data file
+     *  N_STATION: the number of rainfall stations in disaggrgeation
+     *  N_THREAD: the number of threads
+     *  key_from, key_to: only the days in this range (yyyymmdd) are imported;
+     *          with the index (FP_daily.idx) only the months of the range are parsed
+     *  p_rr_d: pointing to the structure df_rr_d array, allocated here
+     * Return:
+     *  output the number of days (rows)
+     * ****************/
+    struct file_map fm, fm_range;
+    struct ingest_task *tasks;
+    long long n_row, i, off_from, off_to;
+    double *p_rr;
+    int k;
+    N_THREAD = (N_THREAD < 1) ? 1 : N_THREAD;
+    if (map_file(FP_daily, &fm) != 0)
+    {
+        printf("Cannot open daily rr data file: %s\n", FP_daily);
+        exit(1);
+    }
+    fm_range = fm;
+    if (
+        (key_from > 0 || key_to < DATE_KEY_MAX) &&
+        date_index_window(FP_daily, key_from, key_to, &off_from, &off_to) == 0 &&
+        off_to <= (long long)fm.size && off_from <= off_to)
+    {
+        /* only the pages of the months in the range are touched */
+        fm_range.data = fm.data + off_from;
+        fm_range.size = (size_t)(off_to - off_from);
+    }
+    n_row = ingest_split(&fm_range, INGEST_DAILY, N_STATION, N_THREAD, FP_daily, key_from, key_to, &tasks);
+    *p_rr_d = (struct df_rr_d *)calloc(n_row + 1, sizeof(struct df_rr_d));
+    p_rr = (double *)malloc(sizeof(double) * N_STATION * (n_row + 1));
+    if (*p_rr_d == NULL || p_rr == NULL)
+    {
+        printf("Memory allocation failed in importing daily rr data file: %s\n", FP_daily);
+        exit(1);
+    }
+    for (i = 0; i < n_row; i++)
+    {
+        (*p_rr_d + i)->p_rr = p_rr + i * N_STATION;
+    }
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].p_df = *p_rr_d;
+        tasks[k].n_keep = n_row;
+    }
+    ingest_run(tasks, N_THREAD);
+    free(tasks);
+    unmap_file(&fm);
+    return (int)n_row;
+}
+
+int import_dfrr_h_parallel(
+    char FP_hourly[],
+    int N_STATION,
+    int N_THREAD,
+    struct df_rr_h **p_rr_h)
+{
+    /**************
+     * Main:
+     *  import hourly rainfall observations into memory, on N_THREAD threads
+     * Parameters:
+     *  FP_hourly: a string, storing the file path and name of hourly rr data file
+     *  N_STATION: the number of rainfall stations in disaggrgeation
+     *  N_THREAD: the number of threads
+     *  p_rr_h: pointing to the structure df_rr_h array, allocated here
+     * Return:
+     *  output the number of hourly observation days (complete days of 24 rows)
+     * ****************/
+    struct file_map fm;
+    struct ingest_task *tasks;
+    long long n_row;
+    int ndays, d, k;
+    double (*p_h)[24];
+    double *p_d;
+    N_THREAD = (N_THREAD < 1) ? 1 : N_THREAD;
+    if (map_file(FP_hourly, &fm) != 0)
+    {
+        printf("Cannot open hourly rr data file: %s\n", FP_hourly);
+        exit(1);
+    }
+    n_row = ingest_split(&fm, INGEST_HOURLY, N_STATION, N_THREAD, FP_hourly, 0, DATE_KEY_MAX, &tasks);
+    ndays = (int)(n_row / 24);
+    *p_rr_h = (struct df_rr_h *)calloc(ndays + 1, sizeof(struct df_rr_h));
+    p_h = (double (*)[24])calloc((size_t)N_STATION * (ndays + 1), sizeof(double) * 24);
+    p_d = (double *)calloc((size_t)N_STATION * (ndays + 1), sizeof(double));
+    if (*p_rr_h == NULL || p_h == NULL || p_d == NULL)
+    {
+        printf("Memory allocation failed in importing hourly rr data file: %s\n", FP_hourly);
+        exit(1);
+    }
+    for (d = 0; d < ndays; d++)
+    {
+        (*p_rr_h + d)->rr_h = p_h + (size_t)d * N_STATION;
+        (*p_rr_h + d)->rr_d = p_d + (size_t)d * N_STATION;
+    }
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].p_df = *p_rr_h;
+        tasks[k].n_keep = (long long)ndays * 24; // the rows of an incomplete last day are ignored
+    }
+    ingest_run(tasks, N_THREAD);
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].pass = 3;
+        tasks[k].day_from = (int)((long long)ndays * k / N_THREAD);
+        tasks[k].day_to = (int)((long long)ndays * (k + 1) / N_THREAD);
+    }
+    ingest_run(tasks, N_THREAD);
+    free(tasks);
+    unmap_file(&fm);
+    return ndays;
+}
+
+int import_df_cp_parallel(
+    char fname[],
+    int N_THREAD,
+    struct df_cp **p_df_cp)
+{
+    /*********************
+     * Main function:
+     *     import the circulation pattern classification results, on N_THREAD threads
+     * Parameters:
+     *     fname: the file path, together with the file name of CP data
+     *     N_THREAD: the number of threads
+     *     p_df_cp: pointing to the struct array of cp data, allocated here
+     * Return:
+     *     the number of rows in the data file
+     *********************/
+    struct file_map fm;
+    struct ingest_task *tasks;
+    long long n_row;
+    int k;
+    N_THREAD = (N_THREAD < 1) ? 1 : N_THREAD;
+    if (map_file(fname, &fm) != 0)
+    {
+        printf("Cannot open cp data file: %s\n", fname);
+        exit(1);
+    }
+    n_row = ingest_split(&fm, INGEST_CP, 0, N_THREAD, fname, 0, DATE_KEY_MAX, &tasks);
+    if ((*p_df_cp = (struct df_cp *)calloc(n_row + 1, sizeof(struct df_cp))) == NULL)
+    {
+        printf("Memory allocation failed in importing cp data file: %s\n", fname);
+        exit(1);
+    }
+    for (k = 0; k < N_THREAD; k++)
+    {
+        tasks[k].p_df = *p_df_cp;
+        tasks[k].n_keep = n_row;
+    }
+    ingest_run(tasks, N_THREAD);
+    free(tasks);
+    unmap_file(&fm);
+    return (int)n_row;
+}
@@ -0,0 +1,26 @@
+#ifndef FUNC_INGEST
+#define FUNC_INGEST
+
+int import_dfrr_d_parallel(
+    char FP_daily[],
+    int N_STATION,
+    int N_THREAD,
+    int key_from,
+    int key_to,
+    struct df_rr_d **p_rr_d
+);
+
+int import_dfrr_h_parallel(
+    char FP_hourly[],
+    int N_STATION,
+    int N_THREAD,
+    struct df_rr_h **p_rr_h
+);
+
+int import_df_cp_parallel(
+    char fname[],
+    int N_THREAD,
+    struct df_cp **p_df_cp
+);
+
+#endif
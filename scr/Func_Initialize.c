@@ -9,9 +9,11 @@
  *               therefore, we assign each day a season (summer or winter) and a cp class
  * DESCRIP-END.
  * FUNCTIONS:    initialize_dfrr_d(); initialize_dfrr_h(); Toogle_CP();
- *               CP_classes();
+ *               CP_classes(); day_number();
  * COMMENTS:
- *
+ * the cp of a day is looked up in an array indexed by the day number (days since
+ * the first day of the cp series), built once per cp series, instead of
+ * scanning the series for every day.
  *
  */
 
@@ -28,6 +30,132 @@
 #include "Func_Initialize.h"
 #include "Func_Fragments.h" // the wet-dry function
 
+struct cp_index
+{
+    /* the cp of each day, indexed by day_number(date) - day0; -1: no cp */
+    struct df_cp *p_cp;     // the cp series the index is built from
+    int nrow_cp;
+    int day0;
+    int n_day;
+    int *cp;
+};
+
+static struct cp_index cpi = {NULL, 0, 0, 0, NULL};
+
+int day_number(
+    struct Date date)
+{
+    // the number of days since 0000-03-01 (proleptic Gregorian calendar), >= 0 for the years >= 0
+    int y = date.y - (date.m <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (date.m + (date.m > 2 ? -3 : 9)) + 2) / 5 + date.d - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe;
+}
+
+static void cp_index_build(
+    struct df_cp *p_cp,
+    int nrow_cp)
+{
+    // (re)build the day-number index of the cp series, unless it is already built
+    int i, k, day_max;
+    if (cpi.p_cp == p_cp && cpi.nrow_cp == nrow_cp)
+    {
+        return;
+    }
+    free(cpi.cp);
+    cpi.p_cp = p_cp;
+    cpi.nrow_cp = nrow_cp;
+    cpi.day0 = 0;
+    day_max = -1;
+    for (i = 0; i < nrow_cp; i++)
+    {
+        k = day_number((p_cp + i)->date);
+        if (i == 0 || k < cpi.day0)
+        {
+            cpi.day0 = k;
+        }
+        if (i == 0 || k > day_max)
+        {
+            day_max = k;
+        }
+    }
+    cpi.n_day = (nrow_cp > 0) ? day_max - cpi.day0 + 1 : 0;
+    cpi.cp = (int *)malloc(sizeof(int) * (cpi.n_day + 1));
+    for (k = 0; k < cpi.n_day; k++)
+    {
+        cpi.cp[k] = -1;
+    }
+    for (i = 0; i < nrow_cp; i++)
+    {
+        k = day_number((p_cp + i)->date) - cpi.day0;
+        if (cpi.cp[k] == -1)
+        {
+            cpi.cp[k] = (p_cp + i)->cp; // the first row of a date, as in a linear search
+        }
+    }
+}
+
+static int cp_lookup(
+    struct Date date)
+{
+    // the cp of the day from the index; -1 if the day is not in the cp series
+    int k = day_number(date) - cpi.day0;
+    return (k >= 0 && k < cpi.n_day) ? cpi.cp[k] : -1;
+}
+
+static void cp_missing(
+    struct Date date,
+    struct Date **p_miss,
+    int *n_miss)
+{
+    // collect a day without cp
+    if ((*n_miss & (*n_miss - 1)) == 0)
+    {
+        *p_miss = (struct Date *)realloc(*p_miss, sizeof(struct Date) * (*n_miss > 0 ? 2 * *n_miss : 16));
+    }
+    (*p_miss)[(*n_miss)++] = date;
+}
+
+static void cp_check_missing(
+    struct Date *p_miss,
+    int n_miss)
+{
+    /**************
+     * Description:
+     *      report all the days without cp at once, consecutive days as a range,
+     *      and terminate the program
+     * ***********/
+    int i, k;
+    if (n_miss == 0)
+    {
+        return;
+    }
+    printf("Program terminated: cannot find the cp class for %d days:\n", n_miss);
+    for (i = 0; i < n_miss; i = k)
+    {
+        for (k = i + 1; k < n_miss && day_number(p_miss[k]) == day_number(p_miss[k - 1]) + 1; k++)
+        {
+        }
+        if (k - i == 1)
+        {
+            printf("    %d-%02d-%02d\n", p_miss[i].y, p_miss[i].m, p_miss[i].d);
+        }
+        else
+        {
+            printf(
+                "    %d-%02d-%02d - %d-%02d-%02d (%d days)\n",
+                p_miss[i].y, p_miss[i].m, p_miss[i].d, p_miss[k - 1].y, p_miss[k - 1].m, p_miss[k - 1].d, k - i);
+        }
+        if (FLAG_LOG == 1)
+        {
+            fprintf(p_log, "cannot find the cp class for %d-%02d-%02d (%d days)\n", p_miss[i].y, p_miss[i].m, p_miss[i].d, k - i);
+        }
+    }
+    exit(2);
+}
+
 void initialize_dfrr_d(
     struct Para_global *p_gp,
     struct df_rr_d *p_rr_d,
@@ -48,11 +176,19 @@ void initialize_dfrr_d(
     int N_SM_CLASS;
     if (strncmp(p_gp->T_CP, "TRUE", 4) == 0)
     {
+        struct Date *p_miss = NULL;
+        int n_miss = 0;
         N_CP_CLASS = CP_classes(p_cp, nrow_cp);
+        cp_index_build(p_cp, nrow_cp);
         for (size_t i = 0; i < nrow_rr_d; i++)
         {
-            (p_rr_d + i)->cp = Toogle_CP((p_rr_d + i)->date, p_cp, nrow_cp);
+            if (((p_rr_d + i)->cp = cp_lookup((p_rr_d + i)->date)) == -1)
+            {
+                cp_missing((p_rr_d + i)->date, &p_miss, &n_miss);
+            }
         }
+        cp_check_missing(p_miss, n_miss);
+        free(p_miss);
     }
     else
     {
@@ -173,11 +309,19 @@ void initialize_dfrr_h(
     int N_CP_CLASS, N_SM_CLASS;
     if (strncmp(p_gp->T_CP, "TRUE", 4) == 0)
     {
+        struct Date *p_miss = NULL;
+        int n_miss = 0;
         N_CP_CLASS = CP_classes(p_cp, nrow_cp);
+        cp_index_build(p_cp, nrow_cp);
         for (size_t i = 0; i < nrow_rr_d; i++)
         {
-            (p_rr_h + i)->cp = Toogle_CP((p_rr_h + i)->date, p_cp, nrow_cp);
+            if (((p_rr_h + i)->cp = cp_lookup((p_rr_h + i)->date)) == -1)
+            {
+                cp_missing((p_rr_h + i)->date, &p_miss, &n_miss);
+            }
         }
+        cp_check_missing(p_miss, n_miss);
+        free(p_miss);
     }
     else
     {
@@ -278,17 +422,9 @@ int Toogle_CP(
      * Output:
      *      return the derived cp value
      * **********/
-    int i;
-    int cp = -1;
-    for (i = 0; i < nrow_cp; i++)
-    {
-        if (
-            (p_cp + i)->date.y == date.y && (p_cp + i)->date.m == date.m && (p_cp + i)->date.d == date.d)
-        {
-            cp = (p_cp + i)->cp;
-            break; // terminate the loop directly
-        }
-    }
+    int cp;
+    cp_index_build(p_cp, nrow_cp);
+    cp = cp_lookup(date);
     if (cp == -1)
     {
         printf(
@@ -26,6 +26,10 @@ int Toogle_CP(
     int nrow_cp
 );
 
+int day_number(
+    struct Date date
+);
+
 int CP_classes(
     struct df_cp *p_cp,
     int nrow_cp
@@ -8,8 +8,8 @@
  * DESCRIPTION:  preprocessing: normalization or standardization; 
  *               considering the high skewwness of rainfall data
  * DESCRIP-END.
- * FUNCTIONS:    kNN_MOF_SSIM(); Toggle_WD(); kNN_SSIM_sampling();
- *               get_random(); 
+ * FUNCTIONS:    Normalize_rain(); Max_rain_d(); Max_rain_h(); Normalize_rain_d();
+ *               Normalize_rain_h(); Standardize_rain();
  *
  * COMMENTS:
  * normalization: transform the date into the range of [0, 1];
@@ -30,6 +30,28 @@
 #include "def_struct.h"
 #include "Func_Prepro.h"
 
+static void rr_d_pre_alloc(
+    struct df_rr_h *p_rr_h,
+    int nrow_h,
+    int N)
+{
+    // rr_d_pre of all the hourly obs days in one contiguous block (struct df_donor)
+    double *p_pre;
+    if (nrow_h <= 0 || p_rr_h->rr_d_pre != NULL)
+    {
+        return; // already allocated
+    }
+    if ((p_pre = (double *)malloc(sizeof(double) * N * ((size_t)nrow_h + 1))) == NULL)
+    {
+        printf("Memory allocation failed in preprocessing the hourly rr\n");
+        exit(1);
+    }
+    for (int i = 0; i < nrow_h; i++)
+    {
+        (p_rr_h + i)->rr_d_pre = p_pre + (size_t)i * N;
+    }
+}
+
 void Normalize_rain(
     struct Para_global *p_gp,
     struct df_rr_d *p_rr_d,
@@ -37,14 +59,38 @@ void Normalize_rain(
     int nrow_d,
     int nrow_h)
 {
-    int N;
     double max = 0.0; 
     double min = 0.0;
+    double max_h;
     double range;
-    N = p_gp->N_STATION;
+    max = Max_rain_d(p_gp, p_rr_d, nrow_d);
+    max_h = Max_rain_h(p_gp, p_rr_h, nrow_h);
+    if (max_h > max)
+    {
+        max = max_h;
+    }
+
+    range = max - min;
+    if (range <= 0.0)
+    {
+        printf("Error: in normalization, max == min! \n");
+        exit(2);
+    }
+
+    Normalize_rain_d(p_gp, p_rr_d, nrow_d, min, range);
+    Normalize_rain_h(p_gp, p_rr_h, nrow_h, min, range);
+}
+
+double Max_rain_d(
+    struct Para_global *p_gp,
+    struct df_rr_d *p_rr_d,
+    int nrow_d)
+{
+    // the maximum of the daily rr (to be disaggregated); at least 0.0
+    double max = 0.0;
     for (size_t i = 0; i < nrow_d; i++)
     {
-        for (size_t j = 0; j < N; j++)
+        for (size_t j = 0; j < p_gp->N_STATION; j++)
         {
             if ((p_rr_d + i)->p_rr[j] > max)
             {
@@ -52,10 +98,19 @@ void Normalize_rain(
             }
         }
     }
+    return max;
+}
 
+double Max_rain_h(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int nrow_h)
+{
+    // the maximum of the daily rr aggregated from hourly obs; at least 0.0
+    double max = 0.0;
     for (size_t i = 0; i < nrow_h; i++)
     {
-        for (size_t j = 0; j < N; j++)
+        for (size_t j = 0; j < p_gp->N_STATION; j++)
         {
             if ((p_rr_h + i)->rr_d[j] > max)
             {
@@ -63,17 +118,24 @@ void Normalize_rain(
             }
         }
     }
+    return max;
+}
 
-    range = max - min;
-    if (range <= 0.0)
-    {
-        printf("Error: in normalization, max == min! \n");
-        exit(2);
-    }
-
+void Normalize_rain_d(
+    struct Para_global *p_gp,
+    struct df_rr_d *p_rr_d,
+    int nrow_d,
+    double min,
+    double range)
+{
+    int N;
+    N = p_gp->N_STATION;
     for (size_t i = 0; i < nrow_d; i++)
     {
-        (p_rr_d + i)->p_rr_pre = (double *)malloc(sizeof(double) * N);
+        if ((p_rr_d + i)->p_rr_pre == NULL)
+        {
+            (p_rr_d + i)->p_rr_pre = (double *)malloc(sizeof(double) * N);
+        }
         for (size_t j = 0; j < N; j++)
         {
             if ((p_rr_d + i)->p_rr[j] > 0.0)
@@ -84,9 +146,20 @@ void Normalize_rain(
             }
         }
     }
+}
+
+void Normalize_rain_h(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int nrow_h,
+    double min,
+    double range)
+{
+    int N;
+    N = p_gp->N_STATION;
+    rr_d_pre_alloc(p_rr_h, nrow_h, N);
     for (size_t i = 0; i < nrow_h; i++)
     {
-        (p_rr_h + i)->rr_d_pre = (double *)malloc(sizeof(double) * N);
         for (size_t j = 0; j < N; j++)
         {
             if ((p_rr_h + i)->rr_d[j] > 0.0)
@@ -175,9 +248,9 @@ void Standardize_rain(
         }
     }
 
+    rr_d_pre_alloc(p_rr_h, nrow_h, N);
     for (size_t i = 0; i < nrow_h; i++)
     {
-        (p_rr_h + i)->rr_d_pre = (double *)malloc(sizeof(double) * N);
         for (size_t j = 0; j < N; j++)
         {
             if ((p_rr_h + i)->rr_d[j] > 0.0)
@@ -8,6 +8,30 @@ void Normalize_rain(
     int nrow_d,
     int nrow_h);
 
+double Max_rain_d(
+    struct Para_global *p_gp,
+    struct df_rr_d *p_rr_d,
+    int nrow_d);
+
+double Max_rain_h(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int nrow_h);
+
+void Normalize_rain_d(
+    struct Para_global *p_gp,
+    struct df_rr_d *p_rr_d,
+    int nrow_d,
+    double min,
+    double range);
+
+void Normalize_rain_h(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rr_h,
+    int nrow_h,
+    double min,
+    double range);
+
 void Standardize_rain(
     struct Para_global *p_gp,
     struct df_rr_d *p_rr_d,
@@ -15,9 +15,10 @@ void Print_gp(
     time(&tm);
     printf("\n------ Global parameter import completed: %s", ctime(&tm));
     printf(
-        "%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n",
+        "%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n",
         "FP_DAILY", p_gp->FP_DAILY,
         "FP_HOURLY", p_gp->FP_HOURLY,
+        "FP_ARCHIVE", p_gp->FP_ARCHIVE,
         "FP_CP", p_gp->FP_CP,
         "FP_OUT", p_gp->FP_OUT,
         "FP_LOG", p_gp->FP_LOG,
@@ -37,9 +38,10 @@ void Print_gp(
     {
         fprintf(p_log, "\n------ Global parameter import completed: %s", ctime(&tm));
         fprintf(p_log,
-                "%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n",
+                "%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n%-10s: %s\n",
                 "FP_DAILY", p_gp->FP_DAILY,
                 "FP_HOURLY", p_gp->FP_HOURLY,
+                "FP_ARCHIVE", p_gp->FP_ARCHIVE,
                 "FP_CP", p_gp->FP_CP,
                 "FP_OUT", p_gp->FP_OUT,
                 "FP_LOG", p_gp->FP_LOG,
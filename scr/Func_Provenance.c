@@ -0,0 +1,247 @@
+/*
+ * SUMMARY:      Func_Provenance.c
+ * USAGE:        provenance log of the donors, and replay of the disaggregation
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  a disaggregated day is determined by the donors (candidate days
+ *               of the hourly obs) sampled at each recursion depth;
+ *               with FP_PROVENANCE the donors of each target day and run are
+ *               recorded in a compact binary log.
+ *               with REPLAY,TRUE the log is read instead: the fragments of the
+ *               recorded donors are assigned to the daily rr of FP_DAILY without
+ *               any similarity search, e.g. a daily series rescaled by a
+ *               climate change signal. A day (run) not in the log, or with wet
+ *               sites left after the recorded donors, is completed by the kNN
+ *               sampling as usual.
+ * DESCRIP-END.
+ * FUNCTIONS:    prov_open(); prov_donor(); prov_day(); prov_replay(); prov_fallback(); prov_close();
+ *
+ * COMMENTS:
+ * layout of the log (native byte order):
+ *      struct prov_header
+ *      records, in the order of disaggregation (target day, run):
+ *          struct prov_record, int donor[n_donor]
+ * the dry days have no record. The donors are the indexes of the hourly obs,
+ * the replay needs the same FP_HOURLY (FP_ARCHIVE) and classification.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "def_struct.h"
+#include "Func_mmap.h"
+#include "Func_Provenance.h"
+
+#define PROV_MAGIC "KNNMOFP"
+
+static FILE *fp_prov = NULL;        // recording
+static struct file_map prov_map;    // replay: the log in memory
+static char *p_cur = NULL;          // replay: the next record
+static char *p_end = NULL;
+static int *donor = NULL;           // the donors of the current target day (run)
+static int n_donor = 0;
+static int n_alloc = 0;
+static int n_hourly = 0;
+static int n_replay = 0;            // replay: the day-runs taken from the log
+static int n_fallback = 0;          // replay: the day-runs with a kNN sampling
+
+static int prov_key(
+    struct Date date)
+{
+    return date.y * 10000 + date.m * 100 + date.d;
+}
+
+static void donor_reserve(
+    int n)
+{
+    if (n > n_alloc)
+    {
+        n_alloc = (n_alloc == 0) ? 64 : n_alloc * 2;
+        n_alloc = (n_alloc < n) ? n : n_alloc;
+        if ((donor = (int *)realloc(donor, sizeof(int) * n_alloc)) == NULL)
+        {
+            printf("Memory allocation failed in the provenance log\n");
+            exit(1);
+        }
+    }
+}
+
+void prov_open(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rrh,
+    int ndays_h)
+{
+    /**************
+     * Description:
+     *      create the provenance log FP_PROVENANCE, or load it (REPLAY,TRUE)
+     * Parameters:
+     *      p_gp: global parameters
+     *      p_rrh: the hourly rr obs (the donors)
+     *      ndays_h: the number of hourly observation days
+     * ***********/
+    struct prov_header head;
+    memset(&head, 0, sizeof(struct prov_header));
+    memcpy(head.magic, PROV_MAGIC, 8);
+    head.version = PROV_VERSION;
+    head.byte_order = 0x01020304;
+    head.N_STATION = p_gp->N_STATION;
+    head.RUN = p_gp->RUN;
+    head.ndays_h = ndays_h;
+    head.h_first = (ndays_h > 0) ? prov_key(p_rrh[0].date) : 0;
+    head.h_last = (ndays_h > 0) ? prov_key(p_rrh[ndays_h - 1].date) : 0;
+    n_hourly = ndays_h;
+    if (p_gp->FLAG_PROVENANCE == 1)
+    {
+        if (p_gp->FLAG_APPEND == 1 || p_gp->FLAG_RESTART == 1 || p_gp->CHECKPOINT > 0)
+        {
+            printf("Program terminated: FP_PROVENANCE is recorded by a whole run, not with APPEND, CHECKPOINT or RESTART\n");
+            exit(1);
+        }
+        if ((fp_prov = fopen(p_gp->FP_PROVENANCE, "wb")) == NULL)
+        {
+            printf("Cannot create the provenance log: %s\n", p_gp->FP_PROVENANCE);
+            exit(1);
+        }
+        setvbuf(fp_prov, NULL, _IOFBF, 1 << 16);
+        fwrite(&head, sizeof(struct prov_header), 1, fp_prov);
+        return;
+    }
+
+    /* replay */
+    struct prov_header head_log;
+    if (
+        map_file(p_gp->FP_PROVENANCE, &prov_map) != 0 ||
+        prov_map.size < sizeof(struct prov_header))
+    {
+        printf("Program terminated: cannot read the provenance log: %s\n", p_gp->FP_PROVENANCE);
+        exit(1);
+    }
+    memcpy(&head_log, prov_map.data, sizeof(struct prov_header));
+    if (
+        strncmp(head_log.magic, PROV_MAGIC, 8) != 0 || head_log.version != PROV_VERSION ||
+        head_log.byte_order != 0x01020304)
+    {
+        printf("Program terminated: not a provenance log: %s\n", p_gp->FP_PROVENANCE);
+        exit(1);
+    }
+    if (
+        head_log.N_STATION != head.N_STATION || head_log.ndays_h != head.ndays_h ||
+        head_log.h_first != head.h_first || head_log.h_last != head.h_last)
+    {
+        printf("Program terminated: the provenance log %s was recorded with other hourly obs (FP_HOURLY) or N_STATION\n", p_gp->FP_PROVENANCE);
+        exit(1);
+    }
+    p_cur = prov_map.data + sizeof(struct prov_header);
+    p_end = prov_map.data + prov_map.size;
+    n_replay = 0;
+    n_fallback = 0;
+}
+
+void prov_donor(
+    int fragment)
+{
+    // recording: the donor sampled at the next recursion depth of the current target day
+    donor_reserve(n_donor + 1);
+    donor[n_donor++] = fragment;
+}
+
+void prov_day(
+    struct Date target,
+    int run)
+{
+    // recording: write the donors of a target day and run, then begin the next
+    struct prov_record rec;
+    rec.target = prov_key(target);
+    rec.run = run;
+    rec.n_donor = n_donor;
+    if (
+        fwrite(&rec, sizeof(struct prov_record), 1, fp_prov) != 1 ||
+        fwrite(donor, sizeof(int), n_donor, fp_prov) != (size_t)n_donor)
+    {
+        printf("Program terminated: failed in writing the provenance log\n");
+        exit(1);
+    }
+    n_donor = 0;
+}
+
+int prov_replay(
+    struct Date target,
+    int run,
+    int **p_donor)
+{
+    /**************
+     * Description:
+     *      replay: the recorded donors of a target day and run; the log is
+     *      read forward, in the (chronological) order of disaggregation
+     * Parameters:
+     *      p_donor: pointing to the donors (the indexes of the hourly obs)
+     * Output:
+     *      the number of donors; -1: the day and run are not in the log
+     * ***********/
+    struct prov_record rec;
+    int key = prov_key(target);
+    int k;
+    while (p_cur + sizeof(struct prov_record) <= p_end)
+    {
+        memcpy(&rec, p_cur, sizeof(struct prov_record));
+        if (rec.target > key || (rec.target == key && rec.run > run))
+        {
+            break;
+        }
+        if (p_cur + sizeof(struct prov_record) + sizeof(int) * rec.n_donor > p_end)
+        {
+            break; // truncated log
+        }
+        p_cur += sizeof(struct prov_record);
+        if (rec.target == key && rec.run == run)
+        {
+            donor_reserve(rec.n_donor);
+            memcpy(donor, p_cur, sizeof(int) * rec.n_donor);
+            p_cur += sizeof(int) * rec.n_donor;
+            for (k = 0; k < rec.n_donor; k++)
+            {
+                if (donor[k] < 0 || donor[k] >= n_hourly)
+                {
+                    printf("Program terminated: invalid donor %d of %d-%02d-%02d in the provenance log\n",
+                           donor[k], target.y, target.m, target.d);
+                    exit(1);
+                }
+            }
+            n_replay++;
+            *p_donor = donor;
+            return rec.n_donor;
+        }
+        p_cur += sizeof(int) * rec.n_donor;
+    }
+    return -1;
+}
+
+void prov_fallback()
+{
+    // replay: a target day (run) completed by the kNN sampling
+    n_fallback++;
+}
+
+void prov_close()
+{
+    if (fp_prov != NULL)
+    {
+        if (fclose(fp_prov) != 0)
+        {
+            printf("Program terminated: failed in writing the provenance log\n");
+            exit(1);
+        }
+        fp_prov = NULL;
+    }
+    else
+    {
+        printf("------ Replay: %d day-runs from the provenance log, %d with kNN sampling\n", n_replay, n_fallback);
+        unmap_file(&prov_map);
+    }
+    free(donor);
+    donor = NULL;
+    n_alloc = 0;
+    n_donor = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef FUNC_PROVENANCE
+#define FUNC_PROVENANCE
+
+#include "def_struct.h"
+
+#define PROV_VERSION 2
+
+struct prov_header
+{
+    /* header of the provenance log (FP_PROVENANCE) */
+    char magic[8];              // "KNNMOFP"
+    int version;                // PROV_VERSION
+    int byte_order;             // 0x01020304, written in native order
+    int N_STATION;
+    int RUN;
+    int ndays_h;                // number of hourly observation days (the donors)
+    int h_first;                // the first and last hourly observation day: yyyymmdd
+    int h_last;
+    int pad;
+};
+
+struct prov_record
+{
+    /* one target day and run; followed by int donor[n_donor] */
+    int target;                 // the target day: yyyymmdd
+    int run;                    // the simulation run, from 1
+    int n_donor;                // the number of donors (recursion depth)
+};
+
+void prov_open(
+    struct Para_global *p_gp,
+    struct df_rr_h *p_rrh,
+    int ndays_h
+);
+
+void prov_donor(
+    int fragment
+);
+
+void prov_day(
+    struct Date target,
+    int run
+);
+
+int prov_replay(
+    struct Date target,
+    int run,
+    int **p_donor
+);
+
+void prov_fallback();
+
+void prov_close();
+
+#endif
@@ -9,9 +9,12 @@
  *               The SSIM represents how close the two images are to each other.
  * DESCRIP-END.
  * FUNCTIONS:    meanSSIM(); mean(); StandardDeviation(); covariance()
- *               isNODATA();
+ *               isNODATA(); SSIM_stats(); SSIM_moments(); meanSSIM_stats();
  * 
  * COMMENTS:
+ * SSIM_stats() computes the statistics of an image once (the donor days are
+ * scored against many targets); meanSSIM_stats() is then meanSSIM() from the
+ * statistics and the centered images of both: one dot product per pair.
  * 
  * REFERENCEs:
  * All about Structural Similarity Index (SSIM): Theory + Code in PyTorch
@@ -35,9 +38,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include "def_struct.h"
 #include "Func_SSIM.h"
 
 
+static double SSIM_index(
+    double L,
+    double image1_mean,
+    double image2_mean,
+    double image1_sd,
+    double image2_sd,
+    double image_cov,
+    double *k,
+    double *power
+)
+{
+    // the SSIM from the moments of two images
+    double SSIM_l, SSIM_c, SSIM_s, SSIM;
+    double C[3] = {0, 0, 0};
+    for (size_t i = 0; i < 3; i++)
+    {
+        C[i] = pow(*(k + i) * L, 2);
+    }
+    // printf("L:%f, C1:%f, C2:%f, C3:%f\n", L, C[0], C[1], C[2]);
+
+    SSIM_l = (2 * image1_mean * image2_mean + C[0]) / (pow(image1_mean, 2) + pow(image2_mean, 2) + C[0]);
+    SSIM_c = (2 * image1_sd * image2_sd + C[1]) / (pow(image1_sd, 2) + pow(image2_sd, 2) + C[1]);
+    SSIM_s = (image_cov + C[2]) / (image1_sd * image2_sd + C[2]);
+    SSIM = pow(SSIM_l, *(power + 0)) * pow(SSIM_c, *(power + 1)) * pow(SSIM_s, *(power + 2));
+    // printf("SSIM_l:%f, SSIM_c:%f, SSIM_s:%f, SSIM:%f\n", SSIM_l, SSIM_c, SSIM_s, SSIM);
+    return SSIM;
+}
+
 double meanSSIM(
     double *image1,
     double *image2,
@@ -62,20 +94,7 @@ double meanSSIM(
 
     // printf("image1_mean: %f,image2_mean: %f,image1_sd: %f,image2_sd: %f,image_cov: %f\n",
     //        image1_mean, image2_mean, image1_sd, image2_sd, image_cov);
-    double SSIM_l, SSIM_c, SSIM_s, SSIM;
-    double C[3] = {0, 0, 0};
-    for (size_t i = 0; i < 3; i++)
-    {
-        C[i] = pow(*(k + i) * L, 2);
-    }
-    // printf("L:%f, C1:%f, C2:%f, C3:%f\n", L, C[0], C[1], C[2]);
-
-    SSIM_l = (2 * image1_mean * image2_mean + C[0]) / (pow(image1_mean, 2) + pow(image2_mean, 2) + C[0]);
-    SSIM_c = (2 * image1_sd * image2_sd + C[1]) / (pow(image1_sd, 2) + pow(image2_sd, 2) + C[1]);
-    SSIM_s = (image_cov + C[2]) / (image1_sd * image2_sd + C[2]);
-    SSIM = pow(SSIM_l, *(power + 0)) * pow(SSIM_c, *(power + 1)) * pow(SSIM_s, *(power + 2));
-    // printf("SSIM_l:%f, SSIM_c:%f, SSIM_s:%f, SSIM:%f\n", SSIM_l, SSIM_c, SSIM_s, SSIM);
-    return SSIM;
+    return SSIM_index(L, image1_mean, image2_mean, image1_sd, image2_sd, image_cov, k, power);
 }
 
 double mean(
@@ -191,6 +210,109 @@ double SSIM_L(
     return L;
 }
 
+void SSIM_stats(
+    double *image,
+    double NODATA,
+    int size,
+    struct ssim_stats *p_s,
+    double *centered)
+{
+    /**************
+     * Description:
+     *      the statistics of an image for SSIM_moments(), computed as in
+     *      mean(), StandardDeviation() and SSIM_L()
+     * Parameters:
+     *      image: the rr of the sites
+     *      p_s: the statistics (output)
+     *      centered: [size], the image minus its mean, 0 at NODATA (output)
+     * ***********/
+    double image_mean = 0.0;
+    p_s->n = 0;
+    p_s->sum = 0.0;
+    p_s->ss = 0.0;
+    p_s->max = 0.0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (isNODATA(*(image + i), NODATA) == 0)
+        {
+            p_s->n += 1;
+            p_s->sum += *(image + i);
+        }
+        if (*(image + i) > p_s->max)
+        {
+            p_s->max = *(image + i);
+        }
+    }
+    if (p_s->n > 0)
+    {
+        image_mean = p_s->sum / (double) p_s->n;
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        if (isNODATA(*(image + i), NODATA) == 0)
+        {
+            centered[i] = *(image + i) - image_mean;
+            p_s->ss += pow(centered[i], 2);
+        }
+        else
+        {
+            centered[i] = 0.0;
+        }
+    }
+}
+
+void SSIM_moments(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *p_mean,
+    double *p_sd,
+    double *p_cov)
+{
+    /**************
+     * Description:
+     *      the means, standard deviations and covariance of two images
+     *      (image1: target, image2: candidate) from their statistics
+     * Output:
+     *      p_mean, p_sd: 2-element arrays; p_cov
+     * ***********/
+    double sum = 0.0;
+    if (p_s1->n <= 1 || p_s2->n <= 1)
+    {
+        printf("NULL: an empty image is detected!\n");
+        exit(1);
+    }
+    p_mean[0] = p_s1->sum / (double) p_s1->n;
+    p_mean[1] = p_s2->sum / (double) p_s2->n;
+    p_sd[0] = pow(1 / ((double) p_s1->n - 1) * p_s1->ss, 0.5);
+    p_sd[1] = pow(1 / ((double) p_s2->n - 1) * p_s2->ss, 0.5);
+    for (size_t i = 0; i < size; i++)
+    {
+        sum += centered1[i] * centered2[i];
+    }
+    *p_cov = 1 / ((double) p_s1->n - 1) * sum;
+}
+
+double meanSSIM_stats(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *k,
+    double *power
+)
+{
+    // meanSSIM() of two images from their statistics (SSIM_stats())
+    double L;
+    double image_mean[2], image_sd[2], image_cov;
+    L = (p_s1->max > p_s2->max) ? p_s1->max : p_s2->max;
+    SSIM_moments(p_s1, centered1, p_s2, centered2, size, image_mean, image_sd, &image_cov);
+    return SSIM_index(L, image_mean[0], image_mean[1], image_sd[0], image_sd[1], image_cov, k, power);
+}
+
 double Manhattan_distance(
     double *rr_c,
     double *rr_t,
@@ -1,6 +1,8 @@
 #ifndef FUNC_SSIM
 #define FUNC_SSIM
 
+#include "def_struct.h"
+
 double meanSSIM(
     double *image1,
     double *image2,
@@ -44,6 +46,35 @@ double SSIM_L(
     int size
 );
 
+void SSIM_stats(
+    double *image,
+    double NODATA,
+    int size,
+    struct ssim_stats *p_s,
+    double *centered
+);
+
+void SSIM_moments(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *p_mean,
+    double *p_sd,
+    double *p_cov
+);
+
+double meanSSIM_stats(
+    struct ssim_stats *p_s1,
+    double *centered1,
+    struct ssim_stats *p_s2,
+    double *centered2,
+    int size,
+    double *k,
+    double *power
+);
+
 double Manhattan_distance(
     double *rr_c,
     double *rr_t,
@@ -0,0 +1,210 @@
+/*
+ * SUMMARY:      Func_Stats.c
+ * USAGE:        summary statistics of the disaggregated hourly rr, accumulated online
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  with FP_STATS each disaggregated day (run) passed to Write_df_rr_h()
+ *               also goes into the statistics of its station and run:
+ *               - annual maxima of the 1-, 3- and 6-hour sums (the windows are
+ *                 continued across midnight of consecutive days)
+ *               - the fraction of wet hours (>= STATS_WET mm, as written "%.2f")
+ *               - the diurnal cycle: mean rr of each hour of the day
+ *               only the summaries are written; with OUT_FORMAT,NONE the hourly
+ *               output (FP_OUT) is not written at all.
+ * DESCRIP-END.
+ * FUNCTIONS:    stats_open(); stats_add(); stats_close();
+ *
+ * COMMENTS:
+ * FP_STATS (csv), two tables, the first column names the table:
+ *      AMAX,run,station,year,n_days,max_1h,max_3h,max_6h   (when a year is complete)
+ *      DIURNAL,run,station,n_days,wet_fraction,h0,...,h23 (at the end)
+ * the statistics cover the days disaggregated by this run of the program.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "def_struct.h"
+#include "Func_Initialize.h"
+#include "Func_Format.h"
+#include "Func_Stats.h"
+
+#define STATS_HIST 5            // hours kept from the day before: the longest window - 1
+
+static const int stats_window[3] = {1, 3, 6};
+
+struct stats_cell
+{
+    /* the statistics of one station and run */
+    double hist[STATS_HIST];    // the last hours of the day before
+    int n_hist;                 // the number of valid hours in hist
+    int last_day;               // day number of the last day added; -1: none
+    int year;                   // the current year of the annual maxima
+    int n_days_year;            // the days of the current year
+    double amax[3];             // the annual maxima of the 1-, 3- and 6-hour sums
+    long long n_hour;           // the hours (of all days)
+    long long n_wet;            // the wet hours
+    double diurnal[24];         // sum of rr of each hour of the day
+};
+
+static FILE *fp_stats = NULL;
+static struct stats_cell *cells = NULL; // [RUN][N_STATION]
+static int stats_N = 0;
+static int stats_RUN = 0;
+
+void stats_open(
+    struct Para_global *p_gp)
+{
+    // create the statistics file FP_STATS
+    int k;
+    if ((fp_stats = fopen(p_gp->FP_STATS, "w")) == NULL)
+    {
+        printf("Cannot create the statistics file: %s\n", p_gp->FP_STATS);
+        exit(1);
+    }
+    stats_N = p_gp->N_STATION;
+    stats_RUN = p_gp->RUN;
+    cells = (struct stats_cell *)calloc((size_t)stats_N * stats_RUN, sizeof(struct stats_cell));
+    if (cells == NULL)
+    {
+        printf("Memory allocation failed in the statistics of the output\n");
+        exit(1);
+    }
+    for (k = 0; k < stats_N * stats_RUN; k++)
+    {
+        cells[k].last_day = -1;
+    }
+    fprintf(fp_stats, "#AMAX,run,station,year,n_days,max_1h,max_3h,max_6h\n");
+}
+
+static void amax_write(
+    struct stats_cell *p_c,
+    int run,
+    int station)
+{
+    // the annual maxima of a completed year
+    fprintf(
+        fp_stats, "AMAX,%d,%d,%d,%d,%.2f,%.2f,%.2f\n",
+        run, station, p_c->year, p_c->n_days_year, p_c->amax[0], p_c->amax[1], p_c->amax[2]);
+}
+
+void stats_add(
+    struct df_rr_h *p_out,
+    int run)
+{
+    /**************
+     * Description:
+     *      add the hourly rr of one disaggregated day and run to the statistics
+     * Parameters:
+     *      p_out: the disaggregated hourly rr of the day
+     *      run: the index of the simulation run, from 1
+     * ***********/
+    struct stats_cell *p_c;
+    double x[STATS_HIST + 24]; // the hours before the day, then the 24 hours of the day
+    double sum;
+    int day, j, h, w, k, n0;
+    day = day_number(p_out->date);
+    for (j = 0; j < stats_N; j++)
+    {
+        p_c = cells + (size_t)(run - 1) * stats_N + j;
+        if (p_c->last_day >= 0 && p_out->date.y != p_c->year)
+        {
+            amax_write(p_c, run, j + 1);
+        }
+        if (p_c->last_day < 0 || p_out->date.y != p_c->year)
+        {
+            p_c->year = p_out->date.y;
+            p_c->n_days_year = 0;
+            p_c->amax[0] = p_c->amax[1] = p_c->amax[2] = 0.0;
+        }
+        /* the windows continue from the day before only if it is the previous day */
+        n0 = (p_c->last_day == day - 1) ? p_c->n_hist : 0;
+        memcpy(x + STATS_HIST - n0, p_c->hist + STATS_HIST - n0, sizeof(double) * n0);
+        for (h = 0; h < 24; h++)
+        {
+            x[STATS_HIST + h] = (p_out->rr_h[j][h] > 0.0) ? p_out->rr_h[j][h] : 0.0;
+            p_c->diurnal[h] += x[STATS_HIST + h];
+            if (round_fixed2(x[STATS_HIST + h]) >= (long long)(STATS_WET * 100 + 0.5))
+            {
+                p_c->n_wet++;
+            }
+        }
+        for (w = 0; w < 3; w++)
+        {
+            for (h = 0; h < 24; h++)
+            {
+                if (h + 1 + n0 < stats_window[w])
+                {
+                    continue; // the window is not complete
+                }
+                sum = 0.0;
+                for (k = 0; k < stats_window[w]; k++)
+                {
+                    sum += x[STATS_HIST + h - k];
+                }
+                if (sum > p_c->amax[w])
+                {
+                    p_c->amax[w] = sum;
+                }
+            }
+        }
+        memcpy(p_c->hist, x + 24, sizeof(double) * STATS_HIST);
+        p_c->n_hist = STATS_HIST;
+        p_c->last_day = day;
+        p_c->n_days_year++;
+        p_c->n_hour += 24;
+    }
+}
+
+void stats_close()
+{
+    /**************
+     * Description:
+     *      write the annual maxima of the last year and the diurnal cycles,
+     *      and close the statistics file
+     * ***********/
+    struct stats_cell *p_c;
+    int r, j, h;
+    for (r = 0; r < stats_RUN; r++)
+    {
+        for (j = 0; j < stats_N; j++)
+        {
+            p_c = cells + (size_t)r * stats_N + j;
+            if (p_c->last_day >= 0)
+            {
+                amax_write(p_c, r + 1, j + 1);
+            }
+        }
+    }
+    fprintf(fp_stats, "#DIURNAL,run,station,n_days,wet_fraction");
+    for (h = 0; h < 24; h++)
+    {
+        fprintf(fp_stats, ",h%d", h);
+    }
+    fprintf(fp_stats, "\n");
+    for (r = 0; r < stats_RUN; r++)
+    {
+        for (j = 0; j < stats_N; j++)
+        {
+            p_c = cells + (size_t)r * stats_N + j;
+            fprintf(
+                fp_stats, "DIURNAL,%d,%d,%lld,%.4f", r + 1, j + 1, p_c->n_hour / 24,
+                (p_c->n_hour > 0) ? (double)p_c->n_wet / p_c->n_hour : 0.0);
+            for (h = 0; h < 24; h++)
+            {
+                fprintf(fp_stats, ",%.3f", (p_c->n_hour > 0) ? p_c->diurnal[h] / (p_c->n_hour / 24) : 0.0);
+            }
+            fprintf(fp_stats, "\n");
+        }
+    }
+    if (ferror(fp_stats) != 0 || fclose(fp_stats) != 0)
+    {
+        printf("Program terminated: error in writing the statistics file\n");
+        exit(1);
+    }
+    fp_stats = NULL;
+    free(cells);
+    cells = NULL;
+}
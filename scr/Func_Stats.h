@@ -0,0 +1,19 @@
+#ifndef FUNC_STATS
+#define FUNC_STATS
+
+#include "def_struct.h"
+
+#define STATS_WET 0.1           // mm: an hour with at least STATS_WET is wet
+
+void stats_open(
+    struct Para_global *p_gp
+);
+
+void stats_add(
+    struct df_rr_h *p_out,
+    int run
+);
+
+void stats_close();
+
+#endif
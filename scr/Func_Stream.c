@@ -0,0 +1,312 @@
+/*
+ * SUMMARY:      Func_Stream.c
+ * USAGE:        read and write plain or gzip-compressed (.gz) files
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the data files (FP_DAILY, FP_HOURLY, FP_CP) and the output
+ *               (FP_OUT) can be gzip-compressed: a file name ending with ".gz"
+ *               is read (written) through zlib, decompressed (compressed)
+ *               on the fly, without a temporary file; the other files are
+ *               plain stdio streams.
+ *               the file name "-" is the standard input (FP_DAILY) or output
+ *               (FP_OUT), so that the program runs within a pipeline; the
+ *               standard output is flushed after each write (day).
+ * DESCRIP-END.
+ * FUNCTIONS:    is_gz(); is_std(); stream_stdout_reserve(); stream_open_in(); stream_gets(); stream_rewind(); stream_close_in();
+ *               stream_read_all(); stream_open_out(); stream_write(); stream_close_out();
+ *
+ * COMMENTS:
+ * zlib is optional: compiled with HAVE_ZLIB (found by CMake), otherwise a
+ * ".gz" file terminates the program with a message.
+ * with FP_OUT "-" the standard output is reserved for the data: the console
+ * messages (printf) are redirected to the standard error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "Func_Stream.h"
+
+int is_gz(
+    char fname[])
+{
+    // whether the file name ends with ".gz"
+    size_t len = strlen(fname);
+    return (len > 3 && strcmp(fname + len - 3, ".gz") == 0);
+}
+
+int is_std(
+    char fname[])
+{
+    // whether the file name is "-": standard input or output
+    return (strcmp(fname, "-") == 0);
+}
+
+static FILE *fp_stdout_data = NULL; // the standard output, reserved for the data
+
+void stream_stdout_reserve()
+{
+    /**************
+     * Description:
+     *      keep the standard output for the data (FP_OUT "-"), and send
+     *      everything else printed to the console to the standard error
+     * ***********/
+    int fd;
+    fflush(stdout);
+    if ((fd = dup(fileno(stdout))) < 0 || (fp_stdout_data = fdopen(fd, "wb")) == NULL ||
+        dup2(fileno(stderr), fileno(stdout)) < 0)
+    {
+        fprintf(stderr, "Program terminated: cannot reserve the standard output for the data\n");
+        exit(1);
+    }
+}
+
+static void no_zlib(
+    char fname[])
+{
+#ifndef HAVE_ZLIB
+    printf("Program terminated: %s is gzip-compressed, but the program is compiled without zlib\n", fname);
+    exit(1);
+#endif
+}
+
+int stream_open_in(
+    struct stream_in *p_in,
+    char fname[])
+{
+    /**************
+     * Description:
+     *      open a text file for reading, gzip-compressed when the name ends with ".gz"
+     * Output:
+     *      0: success; -1: the file cannot be opened
+     * ***********/
+    p_in->fp = NULL;
+    p_in->gz = NULL;
+    p_in->key_from = 0;
+    p_in->key_to = 99999999; // all the rows
+    p_in->past = 0;
+    p_in->ordered = 0;
+    if (is_std(fname))
+    {
+        p_in->fp = stdin;
+        return 0;
+    }
+    if (is_gz(fname))
+    {
+        no_zlib(fname);
+#ifdef HAVE_ZLIB
+        if ((p_in->gz = gzopen(fname, "rb")) == NULL)
+        {
+            return -1;
+        }
+        gzbuffer((gzFile)p_in->gz, 1 << 17);
+#endif
+        return 0;
+    }
+    return ((p_in->fp = fopen(fname, "r")) == NULL) ? -1 : 0;
+}
+
+char *stream_gets(
+    char *buf,
+    int n,
+    struct stream_in *p_in)
+{
+    // the same as fgets()
+#ifdef HAVE_ZLIB
+    if (p_in->gz != NULL)
+    {
+        return gzgets((gzFile)p_in->gz, buf, n);
+    }
+#endif
+    return fgets(buf, n, p_in->fp);
+}
+
+void stream_rewind(
+    struct stream_in *p_in)
+{
+    p_in->past = 0;
+#ifdef HAVE_ZLIB
+    if (p_in->gz != NULL)
+    {
+        gzrewind((gzFile)p_in->gz);
+        return;
+    }
+#endif
+    rewind(p_in->fp);
+}
+
+void stream_close_in(
+    struct stream_in *p_in)
+{
+#ifdef HAVE_ZLIB
+    if (p_in->gz != NULL)
+    {
+        gzclose((gzFile)p_in->gz);
+    }
+#endif
+    if (p_in->fp != NULL && p_in->fp != stdin)
+    {
+        fclose(p_in->fp);
+    }
+    p_in->fp = NULL;
+    p_in->gz = NULL;
+}
+
+int stream_read_all(
+    char fname[],
+    char **p_data,
+    size_t *p_size)
+{
+    /**************
+     * Description:
+     *      decompress a whole ".gz" file into a heap buffer (to be freed by the caller)
+     * Output:
+     *      0: success; -1: the file cannot be opened or read
+     * ***********/
+    *p_data = NULL;
+    *p_size = 0;
+    no_zlib(fname);
+#ifdef HAVE_ZLIB
+    gzFile gz;
+    size_t size = 1 << 20;
+    int n;
+    if ((gz = gzopen(fname, "rb")) == NULL)
+    {
+        return -1;
+    }
+    gzbuffer(gz, 1 << 17);
+    *p_data = (char *)malloc(size);
+    while (*p_data != NULL)
+    {
+        if (*p_size == size)
+        {
+            size *= 2;
+            *p_data = (char *)realloc(*p_data, size);
+            if (*p_data == NULL)
+            {
+                break;
+            }
+        }
+        n = gzread(gz, *p_data + *p_size, (unsigned)((size - *p_size < (1U << 30)) ? size - *p_size : (1U << 30)));
+        if (n <= 0)
+        {
+            gzclose(gz);
+            return (n == 0) ? 0 : -1;
+        }
+        *p_size += (size_t)n;
+    }
+    printf("Memory allocation failed in decompressing: %s\n", fname);
+    exit(1);
+#endif
+    return -1;
+}
+
+int stream_open_out(
+    struct stream_out *p_out,
+    char fname[],
+    char mode[])
+{
+    /**************
+     * Description:
+     *      create (open) an output file, gzip-compressed when the name ends with ".gz"
+     * Parameters:
+     *      mode: "w" or "wb"; "a" or "ab": append (a gzip file gets a new gzip member)
+     * Output:
+     *      0: success; -1: the file cannot be created
+     * ***********/
+    p_out->fp = NULL;
+    p_out->gz = NULL;
+    p_out->flush = 0;
+    if (is_std(fname))
+    {
+        p_out->fp = (fp_stdout_data != NULL) ? fp_stdout_data : stdout;
+        p_out->flush = 1;
+        return 0;
+    }
+    if (is_gz(fname))
+    {
+        no_zlib(fname);
+#ifdef HAVE_ZLIB
+        // level 6: the zlib default, a fair balance of speed and size
+        if ((p_out->gz = gzopen(fname, (mode[0] == 'a') ? "ab6" : "wb6")) == NULL)
+        {
+            return -1;
+        }
+        gzbuffer((gzFile)p_out->gz, 1 << 17);
+#endif
+        return 0;
+    }
+    return ((p_out->fp = fopen(fname, mode)) == NULL) ? -1 : 0;
+}
+
+size_t stream_write(
+    char *data,
+    size_t len,
+    struct stream_out *p_out)
+{
+    // the same as fwrite(data, 1, len, fp): the number of bytes written
+#ifdef HAVE_ZLIB
+    if (p_out->gz != NULL)
+    {
+        size_t done = 0;
+        int n;
+        while (done < len)
+        {
+            n = gzwrite((gzFile)p_out->gz, data + done, (unsigned)((len - done < (1U << 30)) ? len - done : (1U << 30)));
+            if (n <= 0)
+            {
+                break;
+            }
+            done += (size_t)n;
+        }
+        return done;
+    }
+#endif
+    len = fwrite(data, 1, len, p_out->fp);
+    if (p_out->flush == 1 && fflush(p_out->fp) != 0)
+    {
+        return 0;
+    }
+    return len;
+}
+
+int stream_close_out(
+    struct stream_out *p_out)
+{
+    // 0: success; otherwise an error in writing (flushing) the file
+    int status = 0;
+#ifdef HAVE_ZLIB
+    if (p_out->gz != NULL)
+    {
+        status = (gzclose((gzFile)p_out->gz) == Z_OK) ? 0 : -1;
+    }
+#endif
+    if (p_out->fp != NULL && p_out->fp == stdout)
+    {
+        status = (ferror(p_out->fp) != 0 || fflush(p_out->fp) != 0) ? -1 : 0;
+    }
+    else if (p_out->fp != NULL)
+    {
+        status = (ferror(p_out->fp) != 0 || fclose(p_out->fp) != 0) ? -1 : 0;
+        if (p_out->fp == fp_stdout_data)
+        {
+            fp_stdout_data = NULL;
+        }
+    }
+    p_out->fp = NULL;
+    p_out->gz = NULL;
+    return status;
+}
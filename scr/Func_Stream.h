@@ -0,0 +1,79 @@
+#ifndef FUNC_STREAM
+#define FUNC_STREAM
+
+#include <stdio.h>
+
+struct stream_in
+{
+    /*
+     * a text input file: plain (fp) or gzip-compressed (gz),
+     * selected by the file extension ".gz"
+     */
+    FILE *fp;
+    void *gz;       // gzFile (zlib)
+    int key_from;   // the dates (yyyymmdd) of the rows to import: import_dfrr_d_chunk()
+    int key_to;
+    int past;       // 1: a row after key_to has been read
+    int ordered;    // 1: the months of the rows are chronological (index of the file)
+};
+
+struct stream_out
+{
+    /* an output file: plain (fp) or gzip-compressed (gz) */
+    FILE *fp;
+    void *gz;       // gzFile (zlib)
+    int flush;      // 1: standard output (pipe), flushed after each write
+};
+
+int is_gz(
+    char fname[]
+);
+
+int is_std(
+    char fname[]
+);
+
+void stream_stdout_reserve();
+
+int stream_open_in(
+    struct stream_in *p_in,
+    char fname[]
+);
+
+char *stream_gets(
+    char *buf,
+    int n,
+    struct stream_in *p_in
+);
+
+void stream_rewind(
+    struct stream_in *p_in
+);
+
+void stream_close_in(
+    struct stream_in *p_in
+);
+
+int stream_read_all(
+    char fname[],
+    char **p_data,
+    size_t *p_size
+);
+
+int stream_open_out(
+    struct stream_out *p_out,
+    char fname[],
+    char mode[]
+);
+
+size_t stream_write(
+    char *data,
+    size_t len,
+    struct stream_out *p_out
+);
+
+int stream_close_out(
+    struct stream_out *p_out
+);
+
+#endif
@@ -0,0 +1,554 @@
+/*
+ * SUMMARY:      Func_Writer.c
+ * USAGE:        write the formatted output, optionally on a background thread
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the disaggregation formats the output of a target day (all runs)
+ *               into the current block of the writer and submits it;
+ *               - OUT_QUEUE == 0: the block is written to the file directly
+ *               - OUT_QUEUE > 0: the block is handed over to a background thread
+ *                 through a bounded queue, so that the disk latency overlaps with
+ *                 the candidate scoring of the next target days. When the queue
+ *                 is full, the disaggregation waits (back-pressure).
+ *               with OUT_PARTITION the output is split into one file per run,
+ *               year or station; each file has its own buffer and queue (thread),
+ *               so the files are written concurrently. RUN and STATION keep all
+ *               their files open, at most OUT_FILE_MAX (file descriptors, threads).
+ * DESCRIP-END.
+ * FUNCTIONS:    writer_open(); writer_append(); writer_submit(); writer_sync(); writer_close();
+ *
+ * COMMENTS:
+ * the blocks are not copied: the submitted block is swapped with a
+ * free (already written) slot of the ring buffer, whose memory is reused.
+ * FP_OUT ending with ".gz" is gzip-compressed (Func_Stream.c), csv only.
+ * with OUT_FORMAT,SPARSE only the values other than "0.00" are written
+ * (Format_df_rr_h_sparse()); a day dry in all the runs is one marker row.
+ * with OUT_FORMAT,BINARY each block is a day record (Func_BinOut.c); the
+ * offsets of the records are collected and written as index when closing.
+ * with APPEND,TRUE the existing files are opened for appending (Func_Append.c),
+ * and the last day written is recorded in the state file when closing.
+ * with OUT_FORMAT,NONE no file is written at all.
+ * with RESTART,TRUE the files of the checkpoint (Func_Checkpoint.c) are cut
+ * back to their checkpoint size and continued; the other files are new.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "def_struct.h"
+#include "Func_Writer.h"
+#include "Func_BinOut.h"
+#include "Func_Append.h"
+#include "Func_Checkpoint.h"
+
+static void file_fwrite(
+    struct out_buf *p_buf,
+    struct stream_out *p_out)
+{
+    if (p_buf->len > 0 && stream_write(p_buf->data, p_buf->len, p_out) != p_buf->len)
+    {
+        printf("Program terminated: error in writing output file\n");
+        exit(1);
+    }
+    p_buf->len = 0;
+}
+
+static void *file_thread(
+    void *arg)
+{
+    // the background thread: write the queued blocks in order
+    struct out_file *p_w = (struct out_file *)arg;
+    struct out_buf *p_buf;
+    while (1)
+    {
+        pthread_mutex_lock(&p_w->lock);
+        while (p_w->count == 0 && p_w->stop == 0)
+        {
+            pthread_cond_wait(&p_w->not_empty, &p_w->lock);
+        }
+        if (p_w->count == 0 && p_w->stop == 1)
+        {
+            pthread_mutex_unlock(&p_w->lock);
+            break;
+        }
+        p_buf = p_w->slots + p_w->head;
+        pthread_mutex_unlock(&p_w->lock);
+
+        /* the slot stays counted (not reused) until it is written */
+        file_fwrite(p_buf, &p_w->out);
+
+        pthread_mutex_lock(&p_w->lock);
+        p_w->head = (p_w->head + 1) % p_w->n_slot;
+        p_w->count -= 1;
+        pthread_cond_signal(&p_w->not_full);
+        pthread_mutex_unlock(&p_w->lock);
+    }
+    return NULL;
+}
+
+static void file_open(
+    struct out_file *p_w,
+    char fname[],
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      create (open) an output file and start its writing thread if any
+     * Parameters:
+     *      p_w: the output file
+     *      fname: file path and name of the output
+     *      p_gp: global parameters (of this file), OUT_QUEUE: the capacity of the
+     *            queue (day blocks), 0: synchronous writing; OUT_FORMAT
+     * ***********/
+    struct binout_header head;
+    char head_block[BINOUT_HEAD];
+    FILE *fp_old;
+    int append = 0;
+    long long offset = -1;
+    memset(p_w, 0, sizeof(struct out_file));
+    strcpy(p_w->fname, fname);
+    p_w->p_gp = p_gp;
+    if (strncmp(p_gp->OUT_FORMAT, "BINARY", 6) == 0)
+    {
+        p_w->format = 1;
+    }
+    else if (strncmp(p_gp->OUT_FORMAT, "SPARSE", 6) == 0)
+    {
+        p_w->format = 2;
+    }
+    else
+    {
+        p_w->format = 0;
+    }
+    if (p_w->format == 1 && (is_gz(fname) || is_std(fname)))
+    {
+        // the header of the binary output is completed at the end (seek), not possible in gzip or a pipe
+        printf("Program terminated: OUT_FORMAT,BINARY cannot be written into a gzip file or the standard output: %s\n", fname);
+        exit(1);
+    }
+    if (checkpoint_loaded() == 1)
+    {
+        // restart: continue the file from its size at the checkpoint
+        if ((offset = checkpoint_offset(fname)) >= 0)
+        {
+            checkpoint_truncate(fname, offset);
+            append = 1;
+        }
+    }
+    else if (p_gp->FLAG_APPEND == 1 && p_gp->APPEND_AFTER >= 0 && (fp_old = fopen(fname, "rb")) != NULL)
+    {
+        // append to an existing (non-empty) file, without a new header
+        append = (fgetc(fp_old) != EOF);
+        fclose(fp_old);
+    }
+    if (stream_open_out(&p_w->out, fname, append ? ((p_w->format == 1) ? "r+b" : "a") : ((p_w->format == 1) ? "wb" : "w")) != 0)
+    {
+        printf("Program terminated: cannot create or open output file\n");
+        exit(1);
+    }
+    p_w->is_open = 1;
+    if (append == 1 && p_w->out.fp != NULL)
+    {
+        // the bytes already in the file
+        fseek(p_w->out.fp, 0, SEEK_END);
+        p_w->n_byte = ftell(p_w->out.fp);
+    }
+    if (p_w->format == 1 && append == 1)
+    {
+        /* restart: the day records are of fixed size, the index is derived */
+        binout_header_init(&head, p_gp);
+        p_w->n_index = (int)((p_w->n_byte - BINOUT_HEAD) / head.record_size);
+        p_w->size_index = p_w->n_index + 1024;
+        p_w->index = (long long *)malloc(sizeof(long long) * p_w->size_index);
+        for (int k = 0; k < p_w->n_index; k++)
+        {
+            p_w->index[k] = BINOUT_HEAD + k * head.record_size;
+        }
+    }
+    else if (p_w->format == 1)
+    {
+        /* the header is completed (ndays, index) in file_close() */
+        binout_header_init(&head, p_gp);
+        memset(head_block, 0, BINOUT_HEAD);
+        memcpy(head_block, &head, sizeof(struct binout_header));
+        fwrite(head_block, 1, BINOUT_HEAD, p_w->out.fp);
+        p_w->n_byte = BINOUT_HEAD;
+    }
+    else if (p_w->format == 2 && append == 0)
+    {
+        /* the header row of the sparse output: #SPARSE,N_STATION,RUN */
+        buf_reserve(&p_w->current, 64);
+        p_w->current.len = sprintf(p_w->current.data, "#SPARSE,%d,%d\n", p_gp->N_STATION, p_gp->RUN);
+        p_w->n_byte = p_w->current.len;
+        file_fwrite(&p_w->current, &p_w->out);
+    }
+    p_w->n_slot = (p_gp->OUT_QUEUE > 0) ? p_gp->OUT_QUEUE : 0;
+    if (p_w->n_slot > 0)
+    {
+        p_w->slots = (struct out_buf *)calloc(p_w->n_slot, sizeof(struct out_buf));
+        pthread_mutex_init(&p_w->lock, NULL);
+        pthread_cond_init(&p_w->not_empty, NULL);
+        pthread_cond_init(&p_w->not_full, NULL);
+        if (pthread_create(&p_w->thread, NULL, file_thread, p_w) != 0)
+        {
+            printf("Program terminated: cannot start the output writing thread\n");
+            exit(1);
+        }
+    }
+}
+
+static void file_submit(
+    struct out_file *p_w)
+{
+    /**************
+     * Description:
+     *      submit the current block (formatted output of a target day);
+     *      blocks when the queue is full
+     * ***********/
+    struct out_buf temp;
+    int tail;
+    if (p_w->format == 2 && p_w->day_pending == 1)
+    {
+        if (p_w->day_n == 0)
+        {
+            /* a dry day (all runs): one marker row, run 0 */
+            buf_reserve(&p_w->current, 64);
+            p_w->current.len += sprintf(p_w->current.data + p_w->current.len, "0,%d,%d,%d,0\n", p_w->day.y, p_w->day.m, p_w->day.d);
+        }
+        p_w->day_pending = 0;
+        p_w->day_n = 0;
+    }
+    if (p_w->current.len == 0)
+    {
+        return;
+    }
+    if (p_w->format == 1)
+    {
+        if (p_w->n_index == p_w->size_index)
+        {
+            p_w->size_index = (p_w->size_index > 0) ? p_w->size_index * 2 : 1024;
+            p_w->index = (long long *)realloc(p_w->index, sizeof(long long) * p_w->size_index);
+        }
+        p_w->index[p_w->n_index++] = p_w->n_byte;
+    }
+    p_w->n_byte += p_w->current.len;
+    if (p_w->n_slot == 0)
+    {
+        file_fwrite(&p_w->current, &p_w->out);
+        return;
+    }
+    pthread_mutex_lock(&p_w->lock);
+    while (p_w->count == p_w->n_slot)
+    {
+        pthread_cond_wait(&p_w->not_full, &p_w->lock); // back-pressure
+    }
+    tail = (p_w->head + p_w->count) % p_w->n_slot;
+    temp = p_w->slots[tail];
+    p_w->slots[tail] = p_w->current;
+    p_w->current = temp;
+    p_w->current.len = 0;
+    p_w->count += 1;
+    pthread_cond_signal(&p_w->not_empty);
+    pthread_mutex_unlock(&p_w->lock);
+}
+
+static void file_close(
+    struct out_file *p_w)
+{
+    /**************
+     * Description:
+     *      write the remaining blocks, stop the thread and close the output file
+     * ***********/
+    struct binout_header head;
+    int i;
+    file_submit(p_w);
+    if (p_w->n_slot > 0)
+    {
+        pthread_mutex_lock(&p_w->lock);
+        p_w->stop = 1;
+        pthread_cond_signal(&p_w->not_empty);
+        pthread_mutex_unlock(&p_w->lock);
+        pthread_join(p_w->thread, NULL);
+        pthread_mutex_destroy(&p_w->lock);
+        pthread_cond_destroy(&p_w->not_empty);
+        pthread_cond_destroy(&p_w->not_full);
+        for (i = 0; i < p_w->n_slot; i++)
+        {
+            buf_free(p_w->slots + i);
+        }
+        free(p_w->slots);
+    }
+    buf_free(&p_w->current);
+    if (p_w->format == 1)
+    {
+        /* the index of the day records, and the complete header */
+        fwrite(p_w->index, sizeof(long long), p_w->n_index, p_w->out.fp);
+        binout_header_init(&head, p_w->p_gp);
+        head.ndays = p_w->n_index;
+        head.off_index = p_w->n_byte;
+        fseek(p_w->out.fp, 0, SEEK_SET);
+        fwrite(&head, sizeof(struct binout_header), 1, p_w->out.fp);
+        free(p_w->index);
+    }
+    p_w->is_open = 0;
+    if (stream_close_out(&p_w->out) != 0)
+    {
+        printf("Program terminated: error in closing output file\n");
+        exit(1);
+    }
+}
+
+static void file_append(
+    struct out_file *p_f,
+    struct df_rr_h *p_out,
+    int run)
+{
+    // format the hourly rr of one day and one run into the current block of the file
+    if (p_f->format == 1)
+    {
+        Format_df_rr_h_bin(p_out, p_f->p_gp, run, &p_f->current);
+    }
+    else if (p_f->format == 2)
+    {
+        p_f->day_n += Format_df_rr_h_sparse(p_out, p_f->p_gp, run, &p_f->current);
+        p_f->day = p_out->date;
+        p_f->day_pending = 1;
+    }
+    else
+    {
+        Format_df_rr_h(p_out, p_f->p_gp, run, &p_f->current);
+    }
+}
+
+static void partition_name(
+    char fname_part[],
+    char fname[],
+    char suffix[])
+{
+    // insert the suffix before the file extension: out.csv -> out_run1.csv
+    char *p_dot = strrchr(fname, '.');
+    char *p_dir = strrchr(fname, '/');
+    if (p_dir == NULL)
+    {
+        p_dir = strrchr(fname, '\\');
+    }
+    if (p_dot == NULL || (p_dir != NULL && p_dot < p_dir))
+    {
+        sprintf(fname_part, "%s%s", fname, suffix);
+    }
+    else
+    {
+        sprintf(fname_part, "%.*s%s%s", (int)(p_dot - fname), fname, suffix, p_dot);
+    }
+}
+
+void writer_open(
+    struct out_writer *p_w,
+    char fname[],
+    struct Para_global *p_gp)
+{
+    /**************
+     * Description:
+     *      create (open) the output file(s) of the disaggregation
+     * Parameters:
+     *      p_w: the writer
+     *      fname: file path and name of the output, FP_OUT
+     *      p_gp: global parameters, OUT_PARTITION:
+     *            NONE: all in FP_OUT;
+     *            RUN: one file per run, FP_OUT_run1, ...(without the run column);
+     *            YEAR: one file per year, FP_OUT_2006, ...;
+     *            STATION: one file per station, FP_OUT_station1, ...
+     * ***********/
+    char fname_part[220];
+    char suffix[20];
+    int i;
+    memset(p_w, 0, sizeof(struct out_writer));
+    strcpy(p_w->fname, fname);
+    p_w->p_gp = p_gp;
+    p_w->gp_file = *p_gp;
+    if (strncmp(p_gp->OUT_PARTITION, "RUN", 3) == 0)
+    {
+        p_w->partition = 1;
+        p_w->n_file = p_gp->RUN;
+        p_w->gp_file.RUN = 1;
+    }
+    else if (strncmp(p_gp->OUT_PARTITION, "YEAR", 4) == 0)
+    {
+        p_w->partition = 2;
+        p_w->n_file = 1; // opened with the first day of each year
+    }
+    else if (strncmp(p_gp->OUT_PARTITION, "STATION", 7) == 0)
+    {
+        p_w->partition = 3;
+        p_w->n_file = p_gp->N_STATION;
+        p_w->gp_file.N_STATION = 1;
+    }
+    else
+    {
+        p_w->partition = 0;
+        p_w->n_file = 1;
+    }
+    if (strncmp(p_gp->OUT_FORMAT, "NONE", 4) == 0)
+    {
+        // no hourly output, e.g. only the summary statistics (FP_STATS)
+        p_w->partition = 0;
+        p_w->n_file = 0;
+    }
+    if (p_w->partition != 0 && is_std(fname))
+    {
+        printf("Program terminated: OUT_PARTITION is not possible with the standard output (FP_OUT -)\n");
+        exit(1);
+    }
+    if (p_w->n_file > OUT_FILE_MAX)
+    {
+        printf(
+            "Program terminated: OUT_PARTITION,%s gives %d output files, more than %d can be open at once\n",
+            (p_w->partition == 1) ? "RUN" : "STATION", p_w->n_file, OUT_FILE_MAX);
+        exit(1);
+    }
+    p_w->files = (struct out_file *)calloc(p_w->n_file, sizeof(struct out_file));
+    for (i = 0; i < p_w->n_file; i++)
+    {
+        if (p_w->partition == 0)
+        {
+            file_open(p_w->files, fname, p_gp);
+        }
+        else if (p_w->partition == 1 || p_w->partition == 3)
+        {
+            sprintf(suffix, (p_w->partition == 1) ? "_run%d" : "_station%d", i + 1);
+            partition_name(fname_part, fname, suffix);
+            file_open(p_w->files + i, fname_part, &p_w->gp_file);
+        }
+    }
+}
+
+void writer_append(
+    struct out_writer *p_w,
+    struct df_rr_h *p_out,
+    int run)
+{
+    /**************
+     * Description:
+     *      format the hourly rr of one day and one run into the file(s) of its partition
+     * Parameters:
+     *      p_out: the disaggregated hourly rr of the day
+     *      run: the index of the simulation run, from 1
+     * ***********/
+    char fname_part[220];
+    char suffix[20];
+    struct df_rr_h df_station;
+    int j;
+    p_w->last = p_out->date;
+    if (p_w->n_file == 0)
+    {
+        return;
+    }
+    switch (p_w->partition)
+    {
+    case 1:
+        file_append(p_w->files + run - 1, p_out, 1);
+        break;
+    case 2:
+        if (p_out->date.y != p_w->year)
+        {
+            /* a new year: the file of the last year is completed */
+            if (p_w->year != 0)
+            {
+                file_close(p_w->files);
+            }
+            sprintf(suffix, "_%d", p_out->date.y);
+            partition_name(fname_part, p_w->fname, suffix);
+            file_open(p_w->files, fname_part, p_w->p_gp);
+            p_w->year = p_out->date.y;
+        }
+        file_append(p_w->files, p_out, run);
+        break;
+    case 3:
+        df_station = *p_out;
+        for (j = 0; j < p_w->n_file; j++)
+        {
+            df_station.rr_h = p_out->rr_h + j; // [1][24], the station j only
+            file_append(p_w->files + j, &df_station, run);
+        }
+        break;
+    default:
+        file_append(p_w->files, p_out, run);
+    }
+}
+
+void writer_submit(
+    struct out_writer *p_w)
+{
+    /**************
+     * Description:
+     *      submit the formatted output of a target day (all runs) to the file(s);
+     *      blocks when the queue of a file is full
+     * ***********/
+    int i;
+    for (i = 0; i < p_w->n_file; i++)
+    {
+        if (p_w->files[i].is_open == 1)
+        {
+            file_submit(p_w->files + i);
+        }
+    }
+}
+
+void writer_sync(
+    struct out_writer *p_w)
+{
+    /**************
+     * Description:
+     *      wait until the submitted blocks are written, and flush the file(s):
+     *      the size of each file is then its n_byte (checkpoint)
+     * ***********/
+    struct out_file *p_f;
+    int i;
+    for (i = 0; i < p_w->n_file; i++)
+    {
+        p_f = p_w->files + i;
+        if (p_f->is_open == 0)
+        {
+            continue;
+        }
+        if (p_f->n_slot > 0)
+        {
+            pthread_mutex_lock(&p_f->lock);
+            while (p_f->count > 0)
+            {
+                pthread_cond_wait(&p_f->not_full, &p_f->lock);
+            }
+            pthread_mutex_unlock(&p_f->lock);
+        }
+        if (p_f->out.fp != NULL && fflush(p_f->out.fp) != 0)
+        {
+            printf("Program terminated: error in writing output file\n");
+            exit(1);
+        }
+    }
+}
+
+void writer_close(
+    struct out_writer *p_w)
+{
+    /**************
+     * Description:
+     *      write the remaining output and close the file(s)
+     * ***********/
+    int i;
+    for (i = 0; i < p_w->n_file; i++)
+    {
+        if (p_w->files[i].is_open == 1)
+        {
+            file_close(p_w->files + i);
+        }
+    }
+    free(p_w->files);
+    if (p_w->p_gp->FLAG_APPEND == 1 && p_w->last.y != 0)
+    {
+        append_save_state(p_w->p_gp, p_w->last);
+    }
+}
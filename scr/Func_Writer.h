@@ -0,0 +1,81 @@
+#ifndef FUNC_WRITER
+#define FUNC_WRITER
+
+#include <pthread.h>
+#include "Func_Format.h"
+#include "Func_Stream.h"
+
+#define OUT_FILE_MAX 256        // OUT_PARTITION RUN or STATION: files (and writing threads) open at once
+
+struct out_file
+{
+    /*
+     * one output file of the disaggregation, written either directly
+     * (n_slot == 0) or by a background thread from a bounded queue
+     * of formatted day blocks
+     */
+    struct stream_out out;      // the file (plain or gzip-compressed)
+    char fname[220];
+    int is_open;
+    struct out_buf current;     // the block being filled by the disaggregation
+    int n_slot;                 // queue capacity (blocks); 0: synchronous writing
+    struct out_buf *slots;      // ring buffer of the queued blocks
+    int head;                   // the oldest queued block
+    int count;                  // number of queued blocks
+    int stop;                   // 1: no more blocks, the thread finishes the queue and exits
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    struct Para_global *p_gp;   // N_STATION and RUN of this file
+    int format;                 // 0: csv text; 1: binary (OUT_FORMAT,BINARY); 2: sparse csv (SPARSE)
+    long long n_byte;           // bytes submitted (binary: offset of the next day record)
+    long long *index;           // binary: offset of each day record
+    int n_index;
+    int size_index;
+    struct Date day;            // sparse: the day being formatted
+    int day_n;                  // sparse: the number of values of the day (all runs)
+    int day_pending;            // sparse: 1, the day is not submitted yet
+};
+
+struct out_writer
+{
+    /*
+     * the output of the disaggregation: FP_OUT, or one file per
+     * run, year or station (OUT_PARTITION)
+     */
+    int partition;              // 0: none; 1: run; 2: year; 3: station
+    int n_file;
+    struct out_file *files;
+    int year;                   // partition by year: the year of the open file; 0: none open
+    char fname[200];            // FP_OUT; the names of the partition files are derived from it
+    struct Para_global *p_gp;
+    struct Para_global gp_file; // the parameters of a partition file (RUN or N_STATION is 1)
+    struct Date last;           // the last day written; y == 0: none
+};
+
+void writer_open(
+    struct out_writer *p_w,
+    char fname[],
+    struct Para_global *p_gp
+);
+
+void writer_append(
+    struct out_writer *p_w,
+    struct df_rr_h *p_out,
+    int run
+);
+
+void writer_submit(
+    struct out_writer *p_w
+);
+
+void writer_sync(
+    struct out_writer *p_w
+);
+
+void writer_close(
+    struct out_writer *p_w
+);
+
+#endif
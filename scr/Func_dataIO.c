@@ -11,8 +11,8 @@
  *               and hourly rainfall data to provide fragments
  *               write data: write the outputed hourly data into ASCII-format file
  * DESCRIP-END.
- * FUNCTIONS:    import_global(); removeLeadingSpaces(); import_dfrr_d(); import_dfrr_h()
- *               import_df_cp(); Write_df_rr_h();
+ * FUNCTIONS:    import_global(); date_key(); removeLeadingSpaces(); read_line(); import_dfrr_d(); import_dfrr_d_chunk();
+ *               import_dfrr_h(); import_df_cp(); Write_df_rr_h();
  *
  * COMMENTS:
  *
@@ -33,6 +33,12 @@
 
 #include "def_struct.h"
 #include "Func_dataIO.h"
+#include "Func_mmap.h"
+#include "Func_Stream.h"
+#include "Func_Format.h"
+#include "Func_Writer.h"
+#include "Func_Index.h"
+#include "Func_Stats.h"
 
 void import_global(
     char fname[], struct Para_global *p_gp)
@@ -46,21 +52,41 @@ void import_global(
      *      return a structure containing the key fields
      * ********************/
 
-    char row[MAXCHAR];
-    FILE *fp;
+    char *row = NULL;
+    size_t row_size = 0;
+    struct stream_in fp;
     char *token;
     char *token2;
     int i;
 
-    if ((fp = fopen(fname, "r")) == NULL)
+    if (stream_open_in(&fp, fname) != 0)
     {
         printf("cannot open global parameter file: %s\n", fname);
         exit(1);
     }
-    while (fgets(row, MAXCHAR, fp) != NULL)
+    /* default values of the optional parameters */
+    strcpy(p_gp->FP_ARCHIVE, "FALSE");
+    p_gp->STREAM_WINDOW = 0;
+    p_gp->OUT_QUEUE = 0;
+    strcpy(p_gp->OUT_FORMAT, "CSV");
+    strcpy(p_gp->OUT_PARTITION, "NONE");
+    p_gp->N_THREAD = 1;
+    strcpy(p_gp->SSIM_FORMAT, "TEXT");
+    strcpy(p_gp->APPEND, "FALSE");
+    p_gp->APPEND_AFTER = -1;
+    p_gp->CHECKPOINT = 0;
+    strcpy(p_gp->RESTART, "FALSE");
+    p_gp->SEED = 0;
+    p_gp->DATE_FROM = 0;
+    p_gp->DATE_TO = DATE_KEY_MAX;
+    strcpy(p_gp->FP_PROVENANCE, "FALSE");
+    strcpy(p_gp->REPLAY, "FALSE");
+    strcpy(p_gp->FP_STATS, "FALSE");
+    strcpy(p_gp->FP_BALANCE, "FALSE");
+    while (read_line(&fp, &row, &row_size) != NULL)
     {
-        // the fgets() function comes from <stdbool.h>
-        // Reads characters from stream and stores them as a C string
+        // read_line(): reads a whole row of any length from stream,
+        // the row buffer grows when necessary
 
         /***
          * removeLeadingSpaces():
@@ -112,6 +138,10 @@ void import_global(
                 {
                     strcpy(p_gp->FP_OUT, token2);
                 }
+                else if (strncmp(token, "FP_ARCHIVE", 10) == 0)
+                {
+                    strcpy(p_gp->FP_ARCHIVE, token2);
+                }
                 else if (strncmp(token, "FP_LOG", 6) == 0)
                 {
                     strcpy(p_gp->FP_LOG, token2);
@@ -120,6 +150,10 @@ void import_global(
                 {
                     strcpy(p_gp->FP_SSIM, token2);
                 }
+                else if (strncmp(token, "SSIM_FORMAT", 11) == 0)
+                {
+                    strcpy(p_gp->SSIM_FORMAT, token2);
+                }
                 else if (strncmp(token, "PREPROCESS", 10) == 0)
                 {
                     p_gp->PREPROCESS = atof(token2);
@@ -168,6 +202,66 @@ void import_global(
                 {
                     p_gp->CONTINUITY = atoi(token2);
                 }
+                else if (strncmp(token, "STREAM_WINDOW", 13) == 0)
+                {
+                    p_gp->STREAM_WINDOW = atoi(token2);
+                }
+                else if (strncmp(token, "N_THREAD", 8) == 0)
+                {
+                    p_gp->N_THREAD = atoi(token2);
+                }
+                else if (strncmp(token, "OUT_QUEUE", 9) == 0)
+                {
+                    p_gp->OUT_QUEUE = atoi(token2);
+                }
+                else if (strncmp(token, "OUT_FORMAT", 10) == 0)
+                {
+                    strcpy(p_gp->OUT_FORMAT, token2);
+                }
+                else if (strncmp(token, "OUT_PARTITION", 13) == 0)
+                {
+                    strcpy(p_gp->OUT_PARTITION, token2);
+                }
+                else if (strncmp(token, "APPEND", 6) == 0)
+                {
+                    strcpy(p_gp->APPEND, token2);
+                }
+                else if (strncmp(token, "CHECKPOINT", 10) == 0)
+                {
+                    p_gp->CHECKPOINT = atoi(token2);
+                }
+                else if (strncmp(token, "RESTART", 7) == 0)
+                {
+                    strcpy(p_gp->RESTART, token2);
+                }
+                else if (strncmp(token, "SEED", 4) == 0)
+                {
+                    p_gp->SEED = atoll(token2);
+                }
+                else if (strncmp(token, "FP_PROVENANCE", 13) == 0)
+                {
+                    strcpy(p_gp->FP_PROVENANCE, token2);
+                }
+                else if (strncmp(token, "FP_BALANCE", 10) == 0)
+                {
+                    strcpy(p_gp->FP_BALANCE, token2);
+                }
+                else if (strncmp(token, "FP_STATS", 8) == 0)
+                {
+                    strcpy(p_gp->FP_STATS, token2);
+                }
+                else if (strncmp(token, "REPLAY", 6) == 0)
+                {
+                    strcpy(p_gp->REPLAY, token2);
+                }
+                else if (strncmp(token, "START_DATE", 10) == 0)
+                {
+                    p_gp->DATE_FROM = date_key(token2);
+                }
+                else if (strncmp(token, "END_DATE", 8) == 0)
+                {
+                    p_gp->DATE_TO = date_key(token2);
+                }
                 /**********
                  * SSIM parameters
                  * *******/
@@ -205,7 +299,8 @@ void import_global(
             }
         }
     }
-    fclose(fp);
+    stream_close_in(&fp);
+    free(row);
     if (strncmp(p_gp->FP_SSIM, "FALSE", 5) == 0)
     {
         p_gp->flag_SSIM = 0;
@@ -218,9 +313,57 @@ void import_global(
     } else {
         p_gp->FLAG_LOG = 1;
     }
+    if (strncmp(p_gp->FP_ARCHIVE, "FALSE", 5) == 0)
+    {
+        p_gp->FLAG_ARCHIVE = 0;
+    } else {
+        p_gp->FLAG_ARCHIVE = 1;
+    }
+    p_gp->FLAG_APPEND = (strncmp(p_gp->APPEND, "TRUE", 4) == 0) ? 1 : 0;
+    p_gp->FLAG_RESTART = (strncmp(p_gp->RESTART, "TRUE", 4) == 0) ? 1 : 0;
+    if (is_std(p_gp->FP_DAILY) && p_gp->STREAM_WINDOW <= 0)
+    {
+        // FP_DAILY "-": the daily data stream in from the standard input, day by day
+        p_gp->STREAM_WINDOW = 1;
+    }
+    p_gp->FLAG_BALANCE = (strncmp(p_gp->FP_BALANCE, "FALSE", 5) == 0) ? 0 : 1;
+    p_gp->FLAG_STATS = (strncmp(p_gp->FP_STATS, "FALSE", 5) == 0) ? 0 : 1;
+    if (p_gp->FLAG_STATS == 1 && p_gp->FLAG_RESTART == 1)
+    {
+        printf("Program terminated: FP_STATS covers the days of one run, not possible with RESTART\n");
+        exit(1);
+    }
+    p_gp->FLAG_PROVENANCE = 0;
+    if (strncmp(p_gp->FP_PROVENANCE, "FALSE", 5) != 0)
+    {
+        p_gp->FLAG_PROVENANCE = (strncmp(p_gp->REPLAY, "TRUE", 4) == 0) ? 2 : 1;
+    }
+    else if (strncmp(p_gp->REPLAY, "TRUE", 4) == 0)
+    {
+        printf("Program terminated: REPLAY,TRUE needs the provenance log FP_PROVENANCE\n");
+        exit(1);
+    }
+    if (p_gp->DATE_FROM > p_gp->DATE_TO)
+    {
+        printf("Program terminated: START_DATE is after END_DATE\n");
+        exit(1);
+    }
     
 }
 
+int date_key(
+    char *str)
+{
+    // a date yyyy-mm-dd of the global parameter file as the key yyyymmdd
+    int y, m, d;
+    if (str == NULL || sscanf(str, "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31)
+    {
+        printf("Error in global parameter file: invalid date (yyyy-mm-dd): %s\n", (str == NULL) ? "" : str);
+        exit(1);
+    }
+    return y * 10000 + m * 100 + d;
+}
+
 void removeLeadingSpaces(char *str)
 {
     if (str != NULL)
@@ -242,10 +385,56 @@ void removeLeadingSpaces(char *str)
     }
 }
 
+char *read_line(
+    struct stream_in *fp,
+    char **row,
+    size_t *size)
+{
+    /**************
+     * Description:
+     *      read a whole row (line) from the file, regardless of its length
+     * Parameters:
+     *      fp: the input stream (plain or gzip-compressed, Func_Stream.c)
+     *      row: pointing to the row buffer; allocated when NULL and
+     *           enlarged (realloc) for long rows; to be freed by the caller
+     *      size: the current size of the row buffer
+     * Output:
+     *      the row (null-terminated, with '\n' if any); NULL at the end of the file
+     * ***********/
+    size_t len = 0;
+    if (*row == NULL || *size < 2)
+    {
+        *size = 4096;
+        if ((*row = (char *)realloc(*row, *size)) == NULL)
+        {
+            printf("Memory allocation failed in reading a row of %zu bytes\n", *size);
+            exit(1);
+        }
+    }
+    while (stream_gets(*row + len, (int)(*size - len), fp) != NULL)
+    {
+        len += strlen(*row + len);
+        if ((*row)[len - 1] == '\n' || len < *size - 1)
+        {
+            return *row;
+        }
+        /* the row is longer than the buffer */
+        *size *= 2;
+        if ((*row = (char *)realloc(*row, *size)) == NULL)
+        {
+            printf("Memory allocation failed in reading a row of %zu bytes\n", len);
+            exit(1);
+        }
+    }
+    return (len > 0) ? *row : NULL;
+}
+
 int import_dfrr_d(
     char FP_daily[],
     int N_STATION,
-    struct df_rr_d *p_rr_d)
+    int key_from,
+    int key_to,
+    struct df_rr_d **p_rr_d)
 {
     /**************
      * Main:
@@ -253,28 +442,87 @@ int import_dfrr_d(
      * Parameters:
      *  FP_daily: a string, storing the file path and name of daily rr data file
      *  N_STATION: the number of rainfall stations in disaggrgeation
-     *  p_rr_d: name of structure df_rr_d array
+     *  key_from, key_to: only the days in this range (yyyymmdd) are imported
+     *  p_rr_d: pointing to the structure df_rr_d array, allocated (and grown) here
      * Return:
      *  output the number of days (rows)
      * ****************/
     // char FP_daily[]="D:/kNN_MOF_cp/data/rr_obs_daily.csv";  // key parameter
-    FILE *fp_d;
-    if ((fp_d = fopen(FP_daily, "r")) == NULL)
+    struct stream_in fp_d;
+    if (stream_open_in(&fp_d, FP_daily) != 0)
     {
         printf("Cannot open daily rr data file: %s\n", FP_daily);
         exit(1);
     }
-    // struct df_rr_d df_rr_daily[10000];
+    stream_select(&fp_d, FP_daily, key_from, key_to);
+    int i = 0;
+    int n_read;
+    int n_alloc = 4096;
+    *p_rr_d = (struct df_rr_d *)calloc(n_alloc, sizeof(struct df_rr_d));
+    while ((n_read = import_dfrr_d_chunk(&fp_d, N_STATION, *p_rr_d + i, n_alloc - i)) > 0)
+    {
+        i += n_read;
+        if (i == n_alloc)
+        {
+            // the array is full: double the size
+            *p_rr_d = (struct df_rr_d *)realloc(*p_rr_d, sizeof(struct df_rr_d) * n_alloc * 2);
+            if (*p_rr_d == NULL)
+            {
+                printf("Memory allocation failed in importing daily rr data file: %s\n", FP_daily);
+                exit(1);
+            }
+            memset(*p_rr_d + n_alloc, 0, sizeof(struct df_rr_d) * n_alloc);
+            n_alloc *= 2;
+        }
+    }
+    stream_close_in(&fp_d);
+    return i;
+}
+
+int import_dfrr_d_chunk(
+    struct stream_in *fp_d,
+    int N_STATION,
+    struct df_rr_d *p_rr_d,
+    int nrow)
+{
+    /**************
+     * Main:
+     *  import the next (at most) nrow days from the opened daily rr data file
+     * Parameters:
+     *  fp_d: the opened daily rr data file (plain or gzip-compressed)
+     *  N_STATION: the number of rainfall stations in disaggrgeation
+     *  p_rr_d: name of structure df_rr_d array; p_rr of the elements is
+     *          allocated when NULL, otherwise reused
+     *  nrow: the maximum number of rows to import
+     * Return:
+     *  output the number of days (rows) imported; 0 at the end of the file
+     * ****************/
     char *token;
-    char row[MAXCHAR];
-    int i, j;
+    char *row = NULL;
+    size_t row_size = 0;
+    int i, j, key;
     i = 0; // record the number of rows in the data file
-    while (fgets(row, MAXCHAR, fp_d) != NULL)
+    while (i < nrow && fp_d->past == 0 && read_line(fp_d, &row, &row_size) != NULL)
     {
         (p_rr_d + i)->date.y = atoi(strtok(row, ",")); // df_rr_daily[i].
         (p_rr_d + i)->date.m = atoi(strtok(NULL, ","));
         (p_rr_d + i)->date.d = atoi(strtok(NULL, ","));
-        (p_rr_d + i)->p_rr = (double *)malloc(N_STATION * sizeof(double));
+        /* the date range (START_DATE, END_DATE): the read stops at a later month
+         * only when the index has confirmed the months are chronological */
+        key = (p_rr_d + i)->date.y * 10000 + (p_rr_d + i)->date.m * 100 + (p_rr_d + i)->date.d;
+        if (key > fp_d->key_to && fp_d->ordered == 1 && key / 100 > fp_d->key_to / 100)
+        {
+            fp_d->past = 1;
+            break;
+        }
+        if (key < fp_d->key_from || key > fp_d->key_to)
+        {
+            continue;
+        }
+        if ((p_rr_d + i)->p_rr == NULL)
+        {
+            (p_rr_d + i)->p_rr = (double *)malloc(N_STATION * sizeof(double));
+        }
 
         for (j = 0; j < N_STATION; j++)
         {
@@ -283,43 +531,52 @@ int import_dfrr_d(
         }
         i++;
     }
-    fclose(fp_d);
+    free(row);
     return i;
 }
 
 int import_df_coor(
     char fname[],
-    struct df_coor *p_df_coor)
+    struct df_coor **p_df_coor)
 {
     /*************************************
      * read the geographic positions of rain sites:
      * coordinates: longitude and latitude
+     * the struct array *p_df_coor is allocated (and grown) here
      */
-    FILE *fp;
-    if ((fp = fopen(fname, "r")) == NULL)
+    struct stream_in fp;
+    if (stream_open_in(&fp, fname) != 0)
     {
         printf("Cannot open daily rr data file: %s\n", fname);
         exit(1);
     }
-    int i, j;
+    int i;
+    int n_alloc = 256;
     i = 0; // record the number of rows in the data file
-    char *token;
-    char row[MAXCHAR];
-    while (fgets(row, MAXCHAR, fp) != NULL)
+    char *row = NULL;
+    size_t row_size = 0;
+    *p_df_coor = (struct df_coor *)malloc(sizeof(struct df_coor) * n_alloc);
+    while (read_line(&fp, &row, &row_size) != NULL)
     {
-        (p_df_coor + i)->id = atoi(strtok(row, ","));
-        (p_df_coor + i)->lon = atof(strtok(NULL, ","));
-        (p_df_coor + i)->lat = atof(strtok(NULL, ","));
+        if (i == n_alloc)
+        {
+            n_alloc *= 2;
+            *p_df_coor = (struct df_coor *)realloc(*p_df_coor, sizeof(struct df_coor) * n_alloc);
+        }
+        (*p_df_coor + i)->id = atoi(strtok(row, ","));
+        (*p_df_coor + i)->lon = atof(strtok(NULL, ","));
+        (*p_df_coor + i)->lat = atof(strtok(NULL, ","));
         i++;
     }
-    fclose(fp);
+    stream_close_in(&fp);
+    free(row);
     return i;
 }
 
 int import_dfrr_h(
     char FP_hourly[],
     int N_STATION,
-    struct df_rr_h *p_rr_h)
+    struct df_rr_h **p_rr_h)
 {
     /**************
      * Main:
@@ -327,46 +584,82 @@ int import_dfrr_h(
      * Parameters:
      *  FP_hourly: a string, storing the file path and name of hourly rr data file
      *  N_STATION: the number of rainfall stations in disaggrgeation
-     *  p_rr_h: name of structure df_rr_h array
+     *  p_rr_h: pointing to the structure df_rr_h array, allocated here
      * Return:
      *  output the number of hourly observation days
+     * Comments:
+     *  the file is mapped into memory and tokenized in place (Func_mmap.c);
+     *  the daily rr (rr_d) is aggregated in the same pass
      * ****************/
     // char FP_hourly[]="D:/kNN_MOF_cp/data/rr_obs_hourly.csv";
-    FILE *fp_h;
-    if ((fp_h = fopen(FP_hourly, "r")) == NULL)
+    struct file_map fm;
+    if (map_file(FP_hourly, &fm) != 0)
     {
         printf("Cannot open hourly rr data file: %s\n", FP_hourly);
         exit(1);
     }
-    char *token;
-    char row[MAXCHAR];
-    int j, h, nrow_total, ndays;
+    char *p, *row_end, *end;
+    int j, h, ndays;
     int i = 0;
+    double value;
 
+    end = fm.data + fm.size;
+    /* 24 rows per day: the size of the struct array is known in advance */
+    size_t n_day = count_lines(fm.data, end) / 24 + 1;
+    *p_rr_h = (struct df_rr_h *)calloc(n_day, sizeof(struct df_rr_h));
+    /* the rr of all the days in two contiguous blocks (struct df_donor) */
+    double (*p_h)[24] = (double (*)[24])calloc((size_t)N_STATION * n_day, sizeof(double) * 24);
+    double *p_d = (double *)calloc((size_t)N_STATION * n_day, sizeof(double));
+    if (*p_rr_h == NULL || p_h == NULL || p_d == NULL)
+    {
+        printf("Memory allocation failed in importing hourly rr data file: %s\n", FP_hourly);
+        exit(1);
+    }
     struct df_rr_h *p_df_rr_h; // pointer of df_rr_h; for iteration
-    p_df_rr_h = p_rr_h;        // initialize
-    while (fgets(row, MAXCHAR, fp_h) != NULL)
+    p_df_rr_h = *p_rr_h;       // initialize
+    for (p = fm.data; p < end; p = next_line(row_end, end))
     {
+        row_end = memchr(p, '\n', (size_t)(end - p));
+        if (row_end == NULL)
+        {
+            row_end = end;
+        }
+        if (row_end - p <= 1)
+        {
+            continue; // empty row (like the last one)
+        }
         if (i % 24 == 0)
         {
             /* %: remainder after division (modulo division)*/
-            (p_df_rr_h->date).y = atoi(strtok(row, ","));
-            (p_df_rr_h->date).m = atoi(strtok(NULL, ","));
-            (p_df_rr_h->date).d = atoi(strtok(NULL, ","));
-            p_df_rr_h->rr_h = calloc(N_STATION, sizeof(double) * 24); // allocate memory (stack)
+            (p_df_rr_h->date).y = parse_int(&p, row_end);
+            (p_df_rr_h->date).m = parse_int(&p, row_end);
+            (p_df_rr_h->date).d = parse_int(&p, row_end);
+            p_df_rr_h->rr_h = p_h + (size_t)(i / 24) * N_STATION;
+            p_df_rr_h->rr_d = p_d + (size_t)(i / 24) * N_STATION;
         }
         else
         {
             // just skip the date (y, m, d)
-            token = strtok(row, ",");
-            token = strtok(NULL, ",");
-            token = strtok(NULL, ",");
+            skip_field(&p, row_end);
+            skip_field(&p, row_end);
+            skip_field(&p, row_end);
+        }
+        h = parse_int(&p, row_end);
+        if (h < 0 || h > 23)
+        {
+            printf("Invalid hour %d in row %d of hourly rr data file: %s\n", h, i + 1, FP_hourly);
+            exit(1);
         }
-        h = atoi(strtok(NULL, ","));
         for (j = 0; j < N_STATION; j++)
         {
-            token = strtok(NULL, ",");
-            *(*(p_df_rr_h->rr_h + j) + h) = atof(token);
+            if (p >= row_end)
+            {
+                printf("Missing values in row %d of hourly rr data file: %s\n", i + 1, FP_hourly);
+                exit(1);
+            }
+            value = parse_double(&p, row_end);
+            p_df_rr_h->rr_h[j][h] = value;
+            p_df_rr_h->rr_d[j] += value; /**** aggregate the hourly rr into daily scale ****/
         }
         if (i % 24 == 23)
         {
@@ -374,66 +667,65 @@ int import_dfrr_h(
         }
         i++;
     }
-    fclose(fp_h);
-    nrow_total = i;             // the total number of row in the data file
-    ndays = p_df_rr_h - p_rr_h; // the exact size of struct p_rr_h array
-    /**** aggregate the hourly rr into daily scale ****/
-    for (p_df_rr_h = p_rr_h; p_df_rr_h < p_rr_h + ndays; p_df_rr_h++)
-    {
-        p_df_rr_h->rr_d = (double *)malloc(N_STATION * sizeof(double)); // allocate memory (stack)
-        for (j = 0; j < N_STATION; j++)
-        {
-            *(p_df_rr_h->rr_d + j) = 0;
-            for (h = 0; h < 24; h++)
-            {
-                *(p_df_rr_h->rr_d + j) += p_df_rr_h->rr_h[j][h];
-            }
-        }
-    }
+    unmap_file(&fm);
+    ndays = p_df_rr_h - *p_rr_h; // the exact size of struct p_rr_h array
     return ndays; // the last is null
 }
 
 int import_df_cp(
     char fname[],
-    struct df_cp *p_df_cp)
+    struct df_cp **p_df_cp)
 {
     /*********************
      * Main function:
      *     import the circulation pattern classification results
      * Parameters:
      *     fname: the file path, together with the file name of CP data
+     *     p_df_cp: pointing to the struct array of cp data, allocated (and grown) here
      * Return:
      *     bring back struct array of cp data to main() function;
      *     the return value of the function: the number of rows in the data file
      *********************/
-    FILE *fp_cp;
-    char row[MAXCHAR];
+    struct stream_in fp_cp;
+    char *row = NULL;
+    size_t row_size = 0;
     char *token;
     int j = 0; // from the first row
-    if ((fp_cp = fopen(fname, "r")) == NULL)
+    int n_alloc = 4096;
+    if (stream_open_in(&fp_cp, fname) != 0)
     {
         printf("Cannot open cp data file: %s\n", fname);
         exit(1);
     }
-    while (fgets(row, MAXCHAR, fp_cp) != NULL)
+    *p_df_cp = (struct df_cp *)malloc(sizeof(struct df_cp) * n_alloc);
+    while (read_line(&fp_cp, &row, &row_size) != NULL)
     {
-        // the fgets() function comes from <stdbool.h>
-        // Reads characters from stream and stores them as a C string
+        // read_line(): reads a whole row from stream and stores it as a C string
+        if (j == n_alloc)
+        {
+            n_alloc *= 2;
+            if ((*p_df_cp = (struct df_cp *)realloc(*p_df_cp, sizeof(struct df_cp) * n_alloc)) == NULL)
+            {
+                printf("Memory allocation failed in importing cp data file: %s\n", fname);
+                exit(1);
+            }
+        }
         token = strtok(row, ",");
-        p_df_cp[j].date.y = atoi(token);
-        p_df_cp[j].date.m = atoi(strtok(NULL, ","));
-        p_df_cp[j].date.d = atoi(strtok(NULL, ","));
-        p_df_cp[j].cp = atoi(strtok(NULL, ","));
+        (*p_df_cp)[j].date.y = atoi(token);
+        (*p_df_cp)[j].date.m = atoi(strtok(NULL, ","));
+        (*p_df_cp)[j].date.d = atoi(strtok(NULL, ","));
+        (*p_df_cp)[j].cp = atoi(strtok(NULL, ","));
         j++;
     }
-    fclose(fp_cp);
+    stream_close_in(&fp_cp);
+    free(row);
     return j; // the number of rows; the last row is null
 }
 
 void Write_df_rr_h(
     struct df_rr_h *p_out,
     struct Para_global *p_gp,
-    FILE *p_FP_OUT,
+    struct out_writer *p_w,
     int run)
 {
     /**************
@@ -441,28 +733,17 @@ void Write_df_rr_h(
      *      write the disaggregated results into output file (.csv)
      * Parameters:
      *      p_gp:
-     *      p_FP_OUT: a FILE pointer, pointing to the output file
-     *
+     *      p_w: the output writer (Func_Writer.c), pointing to the output file
+     * Comments:
+     *      the 24 rows of the day are formatted into the current block of the
+     *      (partition) file (Func_Writer.c); the block is written once the target
+     *      day is complete, see writer_submit(); OUT_FORMAT,BINARY: a binary day
+     *      record (Func_BinOut.c); FP_STATS: the day also goes into the summary
+     *      statistics (Func_Stats.c)
      * ************/
-    int j, h;
-    for (h = 0; h < 24; h++)
+    writer_append(p_w, p_out, run);
+    if (p_gp->FLAG_STATS == 1)
     {
-        if (p_gp->RUN == 1)
-        {
-            // only one run (simulation)
-            fprintf(p_FP_OUT, "%d,%d,%d,%d", p_out->date.y, p_out->date.m, p_out->date.d, h);
-            // print the date and time (y, m, d, h), together with the value from first rr gauge (0)
-        }
-        else if (p_gp->RUN > 1)
-        {
-            // multiple simulations (realizations)
-            fprintf(p_FP_OUT, "%d,%d,%d,%d,%d", run, p_out->date.y, p_out->date.m, p_out->date.d, h);
-        }
-
-        for (j = 0; j < p_gp->N_STATION; j++)
-        {
-            fprintf(p_FP_OUT, ",%.2f", p_out->rr_h[j][h]);
-        }
-        fprintf(p_FP_OUT, "\n"); // print "\n" (newline) after one row
+        stats_add(p_out, run);
     }
 }
@@ -1,38 +1,60 @@
 #ifndef FUNC_DATAIO
 #define FUNC_DATAIO
 
+#include "Func_Stream.h"
+#include "Func_Writer.h"
+
 void import_global(
     char fname[], struct Para_global *p_gp
 );
 
+int date_key(
+    char *str
+);
+
 void removeLeadingSpaces(char *str);
 
+char *read_line(
+    struct stream_in *fp,
+    char **row,
+    size_t *size
+);
+
 int import_dfrr_d(
     char FP_daily[], 
     int N_STATION,
-    struct df_rr_d *p_rr_d
+    int key_from,
+    int key_to,
+    struct df_rr_d **p_rr_d
+);
+
+int import_dfrr_d_chunk(
+    struct stream_in *fp_d,
+    int N_STATION,
+    struct df_rr_d *p_rr_d,
+    int nrow
 );
 
 int import_df_coor(
     char fname[],
-    struct df_coor *p_df_coor
+    struct df_coor **p_df_coor
 );
 
 int import_dfrr_h(
     char FP_hourly[], 
     int N_STATION,
-    struct df_rr_h *p_rr_h
+    struct df_rr_h **p_rr_h
 );
 
 int import_df_cp(
     char fname[],
-    struct df_cp *p_df_cp
+    struct df_cp **p_df_cp
 );
 
 void Write_df_rr_h(
     struct df_rr_h *p_out,
     struct Para_global *p_gp,
-    FILE *p_FP_OUT,
+    struct out_writer *p_w,
     int run
 );
 
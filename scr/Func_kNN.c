@@ -147,8 +147,33 @@ void kNN_sampling(
     free(weights_cdf);
 }
 
+/* the generator with SEED: splitmix64, its state is saved in the checkpoints */
+static int rng_seeded = 0;
+static unsigned long long rng_state = 0;
+
+void rng_seed(
+    unsigned long long seed)
+{
+    // from now on get_random() draws from the seeded generator
+    rng_state = seed;
+    rng_seeded = 1;
+}
+
+unsigned long long rng_get_state()
+{
+    return rng_state;
+}
+
 double get_random()
 {
+    if (rng_seeded == 1)
+    {
+        unsigned long long z = (rng_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        return (double)(z >> 11) / 9007199254740991.0; // [0, 1], 53 bits
+    }
     int random_number = rand();
     // printf("Random number: %d\n", random_number);
     return ((double)random_number / (double)RAND_MAX);
@@ -184,6 +209,10 @@ int weight_cdf_sample(
 }
 
 void seed_random() {
+    if (rng_seeded == 1)
+    {
+        return; // SEED: one reproducible sequence for the whole run
+    }
     struct timeval tv;
     gettimeofday(&tv, NULL);
     unsigned int seed = (unsigned int)(tv.tv_sec * 1000000 + tv.tv_usec);
@@ -30,6 +30,8 @@ void kNN_sampling(
 
 double get_random();
 void seed_random();
+void rng_seed(unsigned long long seed);
+unsigned long long rng_get_state();
 
 int weight_cdf_sample(
     int size_pool,
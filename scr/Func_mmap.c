@@ -0,0 +1,348 @@
+/*
+ * SUMMARY:      Func_mmap.c
+ * USAGE:        map data files into memory and tokenize them in place
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  the (large) ASCII data files are mapped into memory (mmap)
+ *               and parsed directly from the mapped bytes, without fgets()
+ *               copies and strtok() / atof() calls for every value.
+ *               the numbers are converted by a locale-free parser.
+ * DESCRIP-END.
+ * FUNCTIONS:    map_file(); unmap_file(); count_lines(); next_line();
+ *               parse_int(); parse_double(); skip_field();
+ *
+ * COMMENTS:
+ * - the mapped content is not null-terminated, all the parsing functions
+ *   are therefore bounded by an end pointer (usually the end of the row)
+ * - parse_double() takes the exact fast path (Clinger) when the digits fit
+ *   into 53 bits and the decimal exponent is within [-22, 22], which covers
+ *   all the rainfall values like 12.3 or 0.05; any other token is handed
+ *   over to strtod(), so the result is always identical to atof()
+ * - on Windows (MinGW) the file is simply read into a heap buffer
+ * - a gzip-compressed file (.gz) is decompressed into a heap buffer (Func_Stream.c)
+ *
+ */
+
+/*******************************************************************************
+ * VARIABLEs:
+ * char **pp                    - pointing to the current position in the buffer, advanced by the parsers
+ * char *end                    - the end (exclusive) of the buffer (or of the row)
+ *****/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "Func_mmap.h"
+#include "Func_Stream.h"
+
+static const double pow10_exact[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+int map_file(
+    char fname[],
+    struct file_map *p_map)
+{
+    /**************
+     * Description:
+     *      bring the whole content of a file into memory
+     * Parameters:
+     *      fname: file path and name
+     *      p_map: the file_map struct to be filled
+     * Output:
+     *      0: success; -1: the file cannot be opened or mapped
+     * ***********/
+    p_map->data = NULL;
+    p_map->size = 0;
+    p_map->mapped = 0;
+    if (is_gz(fname))
+    {
+        // gzip-compressed: decompressed into a heap buffer
+        return stream_read_all(fname, &p_map->data, &p_map->size);
+    }
+#ifndef _WIN32
+    int fd;
+    struct stat st;
+    if ((fd = open(fname, O_RDONLY)) < 0)
+    {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size > 0)
+    {
+        void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+        p_map->data = (char *)addr;
+        p_map->size = (size_t)st.st_size;
+        p_map->mapped = 1;
+    }
+    close(fd); // the mapping stays valid after closing the descriptor
+    return 0;
+#else
+    FILE *fp;
+    long size;
+    if ((fp = fopen(fname, "rb")) == NULL)
+    {
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size > 0)
+    {
+        p_map->data = (char *)malloc((size_t)size);
+        if (p_map->data == NULL || fread(p_map->data, 1, (size_t)size, fp) != (size_t)size)
+        {
+            free(p_map->data);
+            p_map->data = NULL;
+            fclose(fp);
+            return -1;
+        }
+        p_map->size = (size_t)size;
+    }
+    fclose(fp);
+    return 0;
+#endif
+}
+
+void unmap_file(
+    struct file_map *p_map)
+{
+    if (p_map->data != NULL)
+    {
+#ifndef _WIN32
+        if (p_map->mapped == 1)
+        {
+            munmap(p_map->data, p_map->size);
+        }
+        else
+        {
+            free(p_map->data);
+        }
+#else
+        free(p_map->data);
+#endif
+    }
+    p_map->data = NULL;
+    p_map->size = 0;
+    p_map->mapped = 0;
+}
+
+size_t count_lines(
+    char *data,
+    char *end)
+{
+    /**************
+     * the number of rows in the buffer;
+     * the last row is also counted when it is not terminated by '\n'
+     * ***********/
+    size_t n = 0;
+    char *p = data;
+    char *q;
+    while (p < end && (q = memchr(p, '\n', (size_t)(end - p))) != NULL)
+    {
+        n++;
+        p = q + 1;
+    }
+    if (p < end)
+    {
+        n++;
+    }
+    return n;
+}
+
+char *next_line(
+    char *p,
+    char *end)
+{
+    // the beginning of the next row (or end)
+    char *q = memchr(p, '\n', (size_t)(end - p));
+    return (q == NULL) ? end : q + 1;
+}
+
+int skip_field(
+    char **pp,
+    char *end)
+{
+    /**************
+     * move to the beginning of the next field (after the next comma);
+     * return 0 when there is no field left in the row
+     * ***********/
+    char *p = *pp;
+    if (p >= end)
+    {
+        return 0;
+    }
+    while (p < end && *p != ',')
+    {
+        p++;
+    }
+    if (p < end)
+    {
+        p++;
+    }
+    *pp = p;
+    return 1;
+}
+
+int parse_int(
+    char **pp,
+    char *end)
+{
+    /**************
+     * the same as atoi() for the field at *pp,
+     * *pp is moved to the beginning of the next field
+     * ***********/
+    char *p = *pp;
+    int neg = 0;
+    int value = 0;
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    *pp = p;
+    skip_field(pp, end);
+    return neg ? -value : value;
+}
+
+double parse_double(
+    char **pp,
+    char *end)
+{
+    /**************
+     * the same as atof() for the field at *pp, but locale-free and
+     * without copying the token; *pp is moved to the beginning of the next field
+     * ***********/
+    char *p = *pp;
+    char *start;
+    int neg = 0;
+    int exp10 = 0;
+    int exact = 1; // 0: too many significant digits for the fast path
+    int n_digits = 0;
+    uint64_t mant = 0;
+    double value;
+
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    start = p;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        if (mant < 100000000000000000ULL)
+        {
+            mant = mant * 10 + (uint64_t)(*p - '0');
+        }
+        else
+        {
+            exact = 0;
+        }
+        n_digits++;
+        p++;
+    }
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (mant < 100000000000000000ULL)
+            {
+                mant = mant * 10 + (uint64_t)(*p - '0');
+                exp10--;
+            }
+            else
+            {
+                exact = 0;
+            }
+            n_digits++;
+            p++;
+        }
+    }
+    if (n_digits > 0 && p < end && (*p == 'e' || *p == 'E'))
+    {
+        char *q = p + 1;
+        int e_neg = 0;
+        int e = 0;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            e_neg = (*q == '-');
+            q++;
+        }
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            while (q < end && *q >= '0' && *q <= '9')
+            {
+                if (e < 10000)
+                {
+                    e = e * 10 + (*q - '0');
+                }
+                q++;
+            }
+            exp10 += e_neg ? -e : e;
+            p = q;
+        }
+    }
+
+    if (n_digits == 0)
+    {
+        // not a number (like NA): atof() gives 0.0
+        value = 0.0;
+    }
+    else if (exact == 1 && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22)
+    {
+        value = (exp10 < 0) ? (double)mant / pow10_exact[-exp10] : (double)mant * pow10_exact[exp10];
+        if (neg)
+        {
+            value = -value;
+        }
+    }
+    else
+    {
+        // rare: hand the token over to strtod()
+        char token[128];
+        size_t len = (size_t)(p - start);
+        if (len > sizeof(token) - 1)
+        {
+            len = sizeof(token) - 1;
+        }
+        memcpy(token, start, len);
+        token[len] = '\0';
+        value = strtod(token, NULL);
+    }
+    *pp = p;
+    skip_field(pp, end);
+    return value;
+}
@@ -0,0 +1,53 @@
+#ifndef FUNC_MMAP
+#define FUNC_MMAP
+
+#include <stddef.h>
+
+struct file_map
+{
+    /*
+     * the whole content of a data file in memory:
+     * data: pointing to the first byte (not null-terminated!)
+     * size: the number of bytes
+     * mapped: 1, memory-mapped (mmap); 0, read into heap buffer
+     */
+    char *data;
+    size_t size;
+    int mapped;
+};
+
+int map_file(
+    char fname[],
+    struct file_map *p_map
+);
+
+void unmap_file(
+    struct file_map *p_map
+);
+
+size_t count_lines(
+    char *data,
+    char *end
+);
+
+char *next_line(
+    char *p,
+    char *end
+);
+
+int parse_int(
+    char **pp,
+    char *end
+);
+
+double parse_double(
+    char **pp,
+    char *end
+);
+
+int skip_field(
+    char **pp,
+    char *end
+);
+
+#endif
@@ -11,7 +11,8 @@
  *               - the similarity is represented by SSIM (structural Similarity Index Measure)
  *               - kNN is used to consider the uncertainty or variability
  * DESCRIP-END.
- * FUNCTIONS:    kNN_MOF_SSIM_Recursive();
+ * FUNCTIONS:    kNN_MOF_SSIM_Recursive(); kNN_MOF_SSIM_Recursive_window(); kNN_MOF_SSIM_Recursive_stream();
+ *               kNN_SSIM_sampling_recursive(); Initialize_output(); Fragment_assign_recursive();
  *
  * COMMENTS:
  *
@@ -38,6 +39,14 @@
 #include "Func_Fragments.h"
 #include "Func_Recursive.h"
 #include "Func_wSSIM.h"
+#include "Func_Initialize.h"
+#include "Func_Prepro.h"
+#include "Func_Diag.h"
+#include "Func_Checkpoint.h"
+#include "Func_Index.h"
+#include "Func_Provenance.h"
+#include "Func_Balance.h"
+#include "Func_Donor.h"
 
 void kNN_MOF_SSIM_Recursive(
     struct df_rr_h *p_rrh,
@@ -57,35 +66,55 @@ void kNN_MOF_SSIM_Recursive(
      *  ndays_h: the number of observations of hourly rr data
      *  nrow_cp: the number of rows in cp series
      * *****************/
-    int i, j, h, k, s, Toggle_wd;
-    int class_t, class_c;
+    struct out_writer writer;
+    struct df_donor donor;
+    donor_build(&donor, p_rrh, ndays_h, p_gp);
+    writer_open(&writer, p_gp->FP_OUT, p_gp);
+    kNN_MOF_SSIM_Recursive_window(p_rrh, &donor, p_rrd, p_gp, 0, nrow_rr_d, ndays_h, &writer);
+    writer_close(&writer);
+    donor_free(&donor);
+}
+
+void kNN_MOF_SSIM_Recursive_window(
+    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
+    struct df_rr_d *p_rrd,
+    struct Para_global *p_gp,
+    int i_from,
+    int i_to,
+    int ndays_h,
+    struct out_writer *p_w)
+{
+    /*******************
+     * Description:
+     *  disaggregate the target days [i_from, i_to) of the daily rr struct array,
+     *  the days before and after are only used as context (CONTINUITY)
+     * Parameters:
+     *  p_don: the donor table of p_rrh (Func_Donor.c)
+     *  i_from, i_to: the index range of the target days in p_rrd
+     *  ndays_h: the number of observations of hourly rr data
+     *  p_w: the output writer, opened by the caller; one block is submitted per target day
+     * *****************/
+    int i, Toggle_wd;
 
     struct df_rr_h df_rr_h_out;                                      // this is a struct variable, not a struct array;
     df_rr_h_out.rr_h = calloc(p_gp->N_STATION, sizeof(double) * 24); // allocate memory (stack);
     df_rr_h_out.rr_d = calloc(p_gp->N_STATION, sizeof(double));
     df_rr_h_out.rr_d_pre = calloc(p_gp->N_STATION, sizeof(double));
+    df_rr_h_out.mask = calloc(WD_WORDS(p_gp->N_STATION), sizeof(uint64_t));
 
-    /************
-     * CONTINUITY and skip
-     * - p_gp->CONTINUITY: 1, skip = 0;
-     * - p_gp->CONTINUITY: 3, skip = 1;
-     * - p_gp->CONTINUITY: 5, skip = 2;
-     * *************/
-    int skip = 0;
-    skip = (int)((p_gp->CONTINUITY - 1) / 2);
-    int pool_cans[MAXrow]; // the index of the candidates (a pool); the size is sufficient
+    int *pool_cans;        // the index of the candidates (a pool): the bucket of the target in p_don
     int n_can;             // the number of candidates after all conditioning (cp and seasonality)
-    int fragment;          // the index of df_rr_h structure with the final chosed fragments
     int WD;
+    int *donor;            // replay: the donors of the day (run) in the provenance log
+    int n_donor;
 
-    FILE *p_FP_OUT;
-    if ((p_FP_OUT = fopen(p_gp->FP_OUT, "w")) == NULL)
-    {
-        printf("Program terminated: cannot create or open output file\n");
-        exit(1);
-    }
-    for (i = 0; i < nrow_rr_d; i++) // iterate each target day
+    for (i = i_from; i < i_to; i++) // iterate each target day
     {
+        if (day_number((p_rrd + i)->date) <= p_gp->APPEND_AFTER)
+        {
+            continue; // append mode or restart: already in the output
+        }
         WD = p_gp->WD;
         Toggle_wd = 0; // initialize with 0 (non-rainy)
         Toggle_wd = Toggle_WD(p_gp->N_STATION, (p_rrd + i)->p_rr);
@@ -97,7 +126,11 @@ void kNN_MOF_SSIM_Recursive(
             for (size_t t = 0; t < p_gp->RUN; t++)
             {
                 /* write the disaggregation output */
-                Write_df_rr_h(&df_rr_h_out, p_gp, p_FP_OUT, t + 1);
+                Write_df_rr_h(&df_rr_h_out, p_gp, p_w, t + 1);
+                if (p_gp->FLAG_BALANCE == 1)
+                {
+                    balance_add(p_rrd + i, &df_rr_h_out, t + 1);
+                }
             }
         }
         else
@@ -107,25 +140,181 @@ void kNN_MOF_SSIM_Recursive(
              * - class: cp type, 12 months, or season (winter or summer)
              * - n_can: the number of candidates after wet-dry status filtering
              * ********/
-            n_can = Filter_WD_Class(p_rrh, p_rrd, i, ndays_h, pool_cans);
+            n_can = Filter_WD_Class(p_don, p_rrd, i, &pool_cans);
             // sample from candidate pool and assign the fragments simultaneously
             for (int t = 0; t < p_gp->RUN; t++)
             {
                 int depth = 0;
                 seed_random();
                 Initialize_output(&df_rr_h_out, p_gp, p_rrd, i); // View_df_h(&df_rr_h_out, p_gp->N_STATION);
-                kNN_SSIM_sampling_recursive(p_rrd, p_rrh, p_gp, &df_rr_h_out, i, pool_cans, n_can, &WD, &depth);
-                Write_df_rr_h(&df_rr_h_out, p_gp, p_FP_OUT, t + 1); /* write the disaggregation output */
+                if (p_gp->FLAG_PROVENANCE == 2 && (n_donor = prov_replay((p_rrd + i)->date, t + 1, &donor)) >= 0)
+                {
+                    /* replay: the recorded donors, without similarity search */
+                    for (depth = 0; depth < n_donor; depth++)
+                    {
+                        Fragment_assign_recursive(p_don, &df_rr_h_out, p_rrd, p_gp, i, donor[depth]);
+                    }
+                    if (wd_any(df_rr_h_out.mask, p_don->n_word) == 1)
+                    {
+                        // wet sites left (e.g. a rescaled series): continue with the kNN sampling
+                        prov_fallback();
+                        kNN_SSIM_sampling_recursive(p_rrd, p_rrh, p_don, p_gp, &df_rr_h_out, i, pool_cans, n_can, &WD, &depth);
+                    }
+                }
+                else
+                {
+                    if (p_gp->FLAG_PROVENANCE == 2)
+                    {
+                        prov_fallback();
+                    }
+                    kNN_SSIM_sampling_recursive(p_rrd, p_rrh, p_don, p_gp, &df_rr_h_out, i, pool_cans, n_can, &WD, &depth);
+                }
+                if (p_gp->FLAG_PROVENANCE == 1)
+                {
+                    prov_day((p_rrd + i)->date, t + 1);
+                }
+                Write_df_rr_h(&df_rr_h_out, p_gp, p_w, t + 1); /* write the disaggregation output */
+                if (p_gp->FLAG_BALANCE == 1)
+                {
+                    balance_add(p_rrd + i, &df_rr_h_out, t + 1);
+                }
             }
         }
+        writer_submit(p_w); // all the runs of the day: written directly, or queued for the writing thread
+        checkpoint_day(p_w, p_gp, (p_rrd + i)->date);
         printf("%d-%02d-%02d: Done!\n", (p_rrd + i)->date.y, (p_rrd + i)->date.m, (p_rrd + i)->date.d);
     }
-    fclose(p_FP_OUT);
+    free(df_rr_h_out.rr_h);
+    free(df_rr_h_out.rr_d);
+    free(df_rr_h_out.rr_d_pre);
+    free(df_rr_h_out.mask);
+}
+
+void kNN_MOF_SSIM_Recursive_stream(
+    struct df_rr_h *p_rrh,
+    struct df_cp *p_cp,
+    struct Para_global *p_gp,
+    int ndays_h,
+    int nrow_cp)
+{
+    /*******************
+     * Description:
+     *  the same as kNN_MOF_SSIM_Recursive(), but the daily rr data file is
+     *  read, classified and disaggregated in windows of STREAM_WINDOW days;
+     *  the peak memory depends on the window size, not on the series length.
+     *  Each window is kept together with (CONTINUITY - 1) / 2 days before and
+     *  after it as context; these days are disaggregated in the previous or
+     *  next window.
+     * Parameters:
+     *  p_rrh: the hourly rr obs (fragments), initialized
+     *  ndays_h: the number of observations of hourly rr data
+     *  nrow_cp: the number of rows in cp series
+     * *****************/
+    int skip, n_buf, n_row, n_read, n_total, i_from, i_to, k;
+    double max, range = 0.0;
+    struct df_rr_d *p_buf;
+    struct df_rr_d df_temp;
+    struct stream_in fp_d;
+    struct out_writer writer;
+    struct df_donor donor;
+
+    skip = (int)((p_gp->CONTINUITY - 1) / 2);
+    n_buf = p_gp->STREAM_WINDOW + 2 * skip; // window + context before and after
+    p_buf = (struct df_rr_d *)calloc(n_buf, sizeof(struct df_rr_d));
+
+    if (stream_open_in(&fp_d, p_gp->FP_DAILY) != 0)
+    {
+        printf("Cannot open daily rr data file: %s\n", p_gp->FP_DAILY);
+        exit(1);
+    }
+    stream_select(&fp_d, p_gp->FP_DAILY, p_gp->DATE_FROM, p_gp->DATE_TO);
+    if (p_gp->PREPROCESS == 1 && is_std(p_gp->FP_DAILY))
+    {
+        printf("Program terminated: PREPROCESS,1 (normalization) needs the whole daily series, not possible with FP_DAILY -\n");
+        exit(1);
+    }
+    if (p_gp->PREPROCESS == 1)
+    {
+        /* normalization needs the maximum of the whole series: one pass ahead */
+        max = Max_rain_h(p_gp, p_rrh, ndays_h);
+        while ((n_read = import_dfrr_d_chunk(&fp_d, p_gp->N_STATION, p_buf, n_buf)) > 0)
+        {
+            if ((range = Max_rain_d(p_gp, p_buf, n_read)) > max)
+            {
+                max = range;
+            }
+        }
+        range = max - 0.0;
+        if (range <= 0.0)
+        {
+            printf("Error: in normalization, max == min! \n");
+            exit(2);
+        }
+        Normalize_rain_h(p_gp, p_rrh, ndays_h, 0.0, range);
+        stream_rewind(&fp_d);
+        stream_select(&fp_d, p_gp->FP_DAILY, p_gp->DATE_FROM, p_gp->DATE_TO);
+    }
+    donor_build(&donor, p_rrh, ndays_h, p_gp);
+    writer_open(&writer, p_gp->FP_OUT, p_gp);
+
+    n_row = 0;   // rows in the buffer
+    i_from = 0;  // the first target day in the buffer
+    n_total = 0;
+    while (1)
+    {
+        n_read = import_dfrr_d_chunk(&fp_d, p_gp->N_STATION, p_buf + n_row, n_buf - n_row);
+        if (n_read <= 0 && n_row <= i_from)
+        {
+            break;
+        }
+        if (n_read > 0)
+        {
+            initialize_dfrr_d(p_gp, p_buf + n_row, p_cp, n_read, nrow_cp);
+            initialize_dfrr_wd(p_gp, p_buf + n_row, p_rrh, n_read, 0);
+            if (p_gp->PREPROCESS == 1)
+            {
+                Normalize_rain_d(p_gp, p_buf + n_row, n_read, 0.0, range);
+            }
+            n_row += n_read;
+        }
+        /* the last window (end of file) takes all the remaining days */
+        i_to = (n_row == n_buf) ? n_buf - skip : n_row;
+        kNN_MOF_SSIM_Recursive_window(p_rrh, &donor, p_buf, p_gp, i_from, i_to, ndays_h, &writer);
+        n_total += i_to - i_from;
+        if (n_row < n_buf)
+        {
+            break;
+        }
+        /* keep the context: move the last 2 * skip days to the beginning (swap to reuse the memory) */
+        for (k = 0; k < 2 * skip; k++)
+        {
+            df_temp = p_buf[k];
+            p_buf[k] = p_buf[n_buf - 2 * skip + k];
+            p_buf[n_buf - 2 * skip + k] = df_temp;
+        }
+        n_row = 2 * skip;
+        i_from = skip;
+    }
+    writer_close(&writer);
+    donor_free(&donor);
+    stream_close_in(&fp_d);
+
+    time_t tm;
+    time(&tm);
+    printf("------ Streaming of daily data (Done): %d days in windows of %d: %s", n_total, p_gp->STREAM_WINDOW, ctime(&tm));
+
+    for (k = 0; k < n_buf; k++)
+    {
+        free(p_buf[k].p_rr);
+        free(p_buf[k].p_rr_pre);
+    }
+    free(p_buf);
 }
 
 void kNN_SSIM_sampling_recursive(
     struct df_rr_d *p_rrd,
     struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct Para_global *p_gp,
     struct df_rr_h *p_out,
     int index_target,
@@ -144,6 +333,7 @@ void kNN_SSIM_sampling_recursive(
      * Parameters:
      *      p_rrd: the daily rainfall st (structure pointer)
      *      p_rrh: pointing to the hourly rr obs structure array
+     *      p_don: the donor table of p_rrh: the daily rr of the candidates
      *      p_gp: pointing to global parameter structure
      *      index_target: the index of target day to be disaggregated
      *      pool_cans: the index pool of candidats
@@ -163,7 +353,7 @@ void kNN_SSIM_sampling_recursive(
         *WD = 1;
     }
     *depth += 1;
-    n_can_final = Filter_WD_multisite(p_rrh, p_out->rr_d, p_gp->N_STATION, n_can, pool_cans, pool_cans_final, *WD);
+    n_can_final = Filter_WD_multisite(p_don, p_out->mask, n_can, pool_cans, pool_cans_final, *WD);
     if (n_can_final == 0)
     {
         printf("No candidae after multi-site wet-dry status filtering!\n");
@@ -181,76 +371,65 @@ void kNN_SSIM_sampling_recursive(
         {
             for (i = 0; i < n_can_final; i++)
             {
-                *(SSIM + i) = Manhattan_distance(p_out->rr_d, (p_rrh + pool_cans_final[i])->rr_d, p_gp->N_STATION);
+                *(SSIM + i) = Manhattan_distance(p_out->rr_d, donor_rr_d(p_don, pool_cans_final[i]), p_gp->N_STATION);
             }
         }
         else
         {
             for (i = 0; i < n_can_final; i++)
             {
-                *(SSIM + i) = Manhattan_distance(p_out->rr_d_pre, (p_rrh + pool_cans_final[i])->rr_d_pre, p_gp->N_STATION);
+                *(SSIM + i) = Manhattan_distance(p_out->rr_d_pre, donor_rr_d_pre(p_don, pool_cans_final[i]), p_gp->N_STATION);
             }
         }
     }
     else
     {
-        // similarity metric: SSIM-based
-        if (p_gp->PREPROCESS == 0)
+        /**********
+         * similarity metric: SSIM-based
+         * the statistics of the candidates are cached in p_don (donor_build()),
+         * those of the target are computed once here;
+         * the images compared are rr_d_pre with preprocessing, otherwise rr_d
+         * ********/
+        struct ssim_stats stats_t, *p_sc;
+        double *img_t, *img_c, *centered_t, L;
+        img_t = (p_gp->PREPROCESS == 0) ? p_out->rr_d : p_out->rr_d_pre;
+        centered_t = (double *)malloc(sizeof(double) * p_gp->N_STATION);
+        SSIM_stats(img_t, p_gp->NODATA, p_gp->N_STATION, &stats_t, centered_t);
+        if (strcmp(p_gp->SIMILARITY, "mSSIM") == 0)
         {
-            if (strcmp(p_gp->SIMILARITY, "mSSIM") == 0)
-            {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = meanSSIM(p_out->rr_d, (p_rrh + pool_cans_final[i])->rr_d, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
-                }
-            } else if (strcmp(p_gp->SIMILARITY, "aSSIM") == 0)
-            {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = ASSIM(p_out->rr_d, (p_rrh + pool_cans_final[i])->rr_d, p_gp->NODATA, p_gp->N_STATION, p_gp->power, 0.1);
-                }
-            } else if (strcmp(p_gp->SIMILARITY, "wSSIM_g") == 0)
-            {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = weightSSIM_Gaussian(p_out->rr_d, (p_rrh + pool_cans_final[i])->rr_d, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
-                }
-            } else if (strcmp(p_gp->SIMILARITY, "wSSIM_e") == 0)
+            for (i = 0; i < n_can_final; i++)
             {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = weightSSIM_ExpoDecay(p_out->rr_d, (p_rrh + pool_cans_final[i])->rr_d, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
-                }
-            } 
-        }
-        else
+                *(SSIM + i) = meanSSIM_stats(
+                    &stats_t, centered_t, donor_stats(p_don, pool_cans_final[i]), donor_centered(p_don, pool_cans_final[i]),
+                    p_gp->N_STATION, p_gp->k, p_gp->power);
+            }
+        } else if (strcmp(p_gp->SIMILARITY, "aSSIM") == 0)
         {
-            if (strcmp(p_gp->SIMILARITY, "mSSIM") == 0)
-            {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = meanSSIM(p_out->rr_d_pre, (p_rrh + pool_cans_final[i])->rr_d_pre, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
-                }
-            } else if (strcmp(p_gp->SIMILARITY, "aSSIM") == 0)
+            for (i = 0; i < n_can_final; i++)
             {
-                for (i = 0; i < n_can_final; i++)
-                {
-                    *(SSIM + i) = ASSIM(p_out->rr_d_pre, (p_rrh + pool_cans_final[i])->rr_d_pre, p_gp->NODATA, p_gp->N_STATION, p_gp->power, 0.1);
-                }
-            } else if (strcmp(p_gp->SIMILARITY, "wSSIM_g") == 0)
+                *(SSIM + i) = ASSIM_stats(
+                    &stats_t, centered_t, donor_stats(p_don, pool_cans_final[i]), donor_centered(p_don, pool_cans_final[i]),
+                    p_gp->N_STATION, p_gp->power, 0.1);
+            }
+        } else if (strcmp(p_gp->SIMILARITY, "wSSIM_g") == 0 || strcmp(p_gp->SIMILARITY, "wSSIM_e") == 0)
+        {
+            // the weights depend on the target: only the max (L) of the candidates is cached
+            for (i = 0; i < n_can_final; i++)
             {
-                for (i = 0; i < n_can_final; i++)
+                p_sc = donor_stats(p_don, pool_cans_final[i]);
+                L = (stats_t.max > p_sc->max) ? stats_t.max : p_sc->max;
+                img_c = (p_gp->PREPROCESS == 0) ? donor_rr_d(p_don, pool_cans_final[i]) : donor_rr_d_pre(p_don, pool_cans_final[i]);
+                if (strcmp(p_gp->SIMILARITY, "wSSIM_g") == 0)
                 {
-                    *(SSIM + i) = weightSSIM_Gaussian(p_out->rr_d_pre, (p_rrh + pool_cans_final[i])->rr_d_pre, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
+                    *(SSIM + i) = weightSSIM_Gaussian(img_t, img_c, p_gp->NODATA, p_gp->N_STATION, L, p_gp->k, p_gp->power);
                 }
-            } else if (strcmp(p_gp->SIMILARITY, "wSSIM_e") == 0)
-            {
-                for (i = 0; i < n_can_final; i++)
+                else
                 {
-                    *(SSIM + i) = weightSSIM_ExpoDecay(p_out->rr_d_pre, (p_rrh + pool_cans_final[i])->rr_d_pre, p_gp->NODATA, p_gp->N_STATION, p_gp->k, p_gp->power);
+                    *(SSIM + i) = weightSSIM_ExpoDecay(img_t, img_c, p_gp->NODATA, p_gp->N_STATION, L, p_gp->k, p_gp->power);
                 }
-            } 
+            }
         }
+        free(centered_t);
     }
 
     int order = 1; // 1: larger SSIM, heavier weight; 0: larger distance, less weight
@@ -262,12 +441,21 @@ void kNN_SSIM_sampling_recursive(
     int run = 1; // sample one candidate each time
     int index_fragment;
     kNN_sampling(SSIM, pool_cans_final, order, n_can_final, run, &index_fragment);
+    if (p_gp->FLAG_PROVENANCE == 1)
+    {
+        prov_donor(index_fragment);
+    }
+    if (p_gp->flag_SSIM == 1)
+    {
+        // the k best candidates, sorted by kNN_sampling()
+        diag_top(p_out->date, *depth, pool_cans_final, SSIM, n_can_final, p_rrh);
+    }
 
     // printf("n_can: %d, fragment: %d\n", n_can_final, index_fragment);
-    Fragment_assign_recursive(p_rrh, p_out, p_rrd, p_gp, index_target, index_fragment);
-    if (Toggle_WD(p_gp->N_STATION, p_out->rr_d) == 1)
+    Fragment_assign_recursive(p_don, p_out, p_rrd, p_gp, index_target, index_fragment);
+    if (wd_any(p_out->mask, p_don->n_word) == 1)
     {
-        kNN_SSIM_sampling_recursive(p_rrd, p_rrh, p_gp, p_out, index_target, pool_cans, n_can, WD, depth);
+        kNN_SSIM_sampling_recursive(p_rrd, p_rrh, p_don, p_gp, p_out, index_target, pool_cans, n_can, WD, depth);
     }
 
     free(pool_cans_final);
@@ -297,10 +485,11 @@ void Initialize_output(
             p_out->rr_h[j][h] = 0.0;
         }
     }
+    wd_mask(p_out->rr_d, p_gp->N_STATION, p_out->mask);
 }
 
 void Fragment_assign_recursive(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_h *p_out,
     struct df_rr_d *p_rrd,
     struct Para_global *p_gp,
@@ -311,7 +500,7 @@ void Fragment_assign_recursive(
      * Description:
      *      disaggregate the target day rainfall into hourly scale based on the selected fragments
      * Parameters:
-     *      p_rrh: pointing to the hourly obs rr structure array
+     *      p_don: the donor table of the hourly obs rr
      *      p_out: pointing to the disaggregated hourly rr results struct (to output)
      *      p_gp: global parameters struct
      *      fragment: the index of p_rrh struct after filtering and resampling
@@ -319,22 +508,27 @@ void Fragment_assign_recursive(
      *      p_out
      * *******/
     int j, h;
+    double x;
+    double *rr_d = donor_rr_d(p_don, fragment);
+    float (*frag)[24] = donor_frag(p_don, fragment);
     for (j = 0; j < p_gp->N_STATION; j++)
     {
         if (p_out->rr_d[j] > 0)
         { // wet site
-            if ((p_rrh + fragment)->rr_d[j] > 0.0)
+            if (rr_d[j] > 0.0)
             {
                 // the same site in candidate day is also wet, then disaggregate it
+                x = p_out->rr_d[j];
                 for (h = 0; h < 24; h++)
                 {
-                    p_out->rr_h[j][h] = p_out->rr_d[j] * (p_rrh + fragment)->rr_h[j][h] / (p_rrh + fragment)->rr_d[j];
+                    p_out->rr_h[j][h] = x * frag[j][h];
                 }
                 /**************
                  * after disaggregating this site, the following
                  * should be updated
                  * **********/
                 p_out->rr_d[j] = 0.0;
+                p_out->mask[j / 64] &= ~((uint64_t)1 << (j % 64));
                 if (p_gp->PREPROCESS != 0)
                 {
                     p_out->rr_d_pre[j] = 0.0;
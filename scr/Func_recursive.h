@@ -1,8 +1,6 @@
 #ifndef FUNC_RECURSIVE
 #define FUNC_RECURSIVE
 
-extern FILE *p_SSIM;
-
 void kNN_MOF_SSIM_Recursive(
     struct df_rr_h *p_rrh,
     struct df_rr_d *p_rrd,
@@ -12,9 +10,27 @@ void kNN_MOF_SSIM_Recursive(
     int ndays_h,
     int nrow_cp);
 
+void kNN_MOF_SSIM_Recursive_window(
+    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
+    struct df_rr_d *p_rrd,
+    struct Para_global *p_gp,
+    int i_from,
+    int i_to,
+    int ndays_h,
+    struct out_writer *p_w);
+
+void kNN_MOF_SSIM_Recursive_stream(
+    struct df_rr_h *p_rrh,
+    struct df_cp *p_cp,
+    struct Para_global *p_gp,
+    int ndays_h,
+    int nrow_cp);
+
 void kNN_SSIM_sampling_recursive(
     struct df_rr_d *p_rrd,
     struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct Para_global *p_gp,
     struct df_rr_h *p_out,
     int index_target,
@@ -34,7 +50,7 @@ void Initialize_output(
 );
 
 void Fragment_assign_recursive(
-    struct df_rr_h *p_rrh,
+    struct df_donor *p_don,
     struct df_rr_h *p_out,
     struct df_rr_d *p_rrd,
     struct Para_global *p_gp,
@@ -49,12 +49,12 @@ double weightSSIM_Gaussian(
     double *image2,
     double NODATA,
     int size,
+    double L,
     double *k,
     double *power
 )
 {
-    double L;
-    L = SSIM_L(image1, image2, NODATA, size);
+    // L: the largest rr of both images (SSIM_L(), or the max of their SSIM_stats())
     double gaussian_mu, gaussian_sigma;
     // assume that the image1 is from the target day
     gaussian_mu = mean(image1, NODATA, size);
@@ -185,12 +185,12 @@ double weightSSIM_ExpoDecay(
     double *image2,
     double NODATA,
     int size,
+    double L,
     double *k,
     double *power
 )
 {
-    double L;
-    L = SSIM_L(image1, image2, NODATA, size);
+    // L: the largest rr of both images (SSIM_L(), or the max of their SSIM_stats())
     double ExpoDecay_mu, ExpoDecay_sigma;
     // assume that the image1 is from the target day
     ExpoDecay_mu = mean(image1, NODATA, size);
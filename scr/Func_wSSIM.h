@@ -6,6 +6,7 @@ double weightSSIM_Gaussian(
     double *image2,
     double NODATA,
     int size,
+    double L,
     double *k,
     double *power
 );
@@ -47,6 +48,7 @@ double weightSSIM_ExpoDecay(
     double *image2,
     double NODATA,
     int size,
+    double L,
     double *k,
     double *power
 );
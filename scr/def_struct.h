@@ -1,9 +1,8 @@
 #ifndef STRUCT_H
 #define STRUCT_H
 
-#define MAXCHAR 10000  // able to accomodate up to 3000 sites simultaneously
-#define MAXrow 100000  // almost 270 years long ts
-#define MAXcps 20
+#include <stdint.h>
+
 #define FloatZero 0.005
 
 /******
@@ -52,12 +51,55 @@ struct df_rr_h
     double (*rr_h)[24];
     double *rr_d;
     double *rr_d_pre;
+    uint64_t *mask;     // the wet sites of rr_d as bits (output day: the sites still to disaggregate)
     int wd;  // wet or dry
     int cp;
     int SM;
     int class;
 };
 
+struct ssim_stats
+{
+    /*
+     * the statistics of a daily rr image in the SSIM similarity,
+     * over the sites not NODATA (see Func_SSIM.c: SSIM_stats())
+     */
+    int n;                  // the number of sites not NODATA
+    double sum;             // the sum of rr
+    double ss;              // the sum of squares of the centered rr (rr - mean)
+    double max;             // the largest rr (0 at least), for L in SSIM
+};
+
+struct df_donor
+{
+    /*
+     * the hourly obs (donor days) as contiguous arrays, indexed by the day k
+     * of the df_rr_h struct array: the candidate scans stream through memory
+     * instead of chasing pointers.
+     * the daily rows (rr_d, rr_d_pre, mask) are stored in the bucket order:
+     * the days of a class and wet-dry status are adjacent rows; row[k] is the
+     * row of day k, bucket[] lists the days in the bucket order.
+     */
+    int ndays;
+    int N;                  // N_STATION
+    struct Date *date;      // [ndays]
+    int *class;             // [ndays]
+    int *wd;                // [ndays]
+    int n_bucket;           // (the largest class + 1) * 2; bucket b = class * 2 + wd
+    int *bucket_from;       // [n_bucket + 1]: the first row of each bucket
+    int *bucket;            // [ndays]: the days k in the bucket order
+    int *row;               // [ndays]: the row of day k
+    double *rr_d;           // [ndays][N], rows in the bucket order
+    double *rr_d_pre;       // [ndays][N], rows in the bucket order; NULL without preprocessing
+    int n_word;             // 64-bit words of a wet mask: (N + 63) / 64
+    uint64_t *mask;         // [ndays][n_word], rows in the bucket order: bit s set when station s is wet (rr_d > 0)
+    struct ssim_stats *stats;   // [ndays], rows in the bucket order: the statistics of the scored image (rr_d_pre, otherwise rr_d)
+    double *centered;       // [ndays][N], rows in the bucket order: the scored image minus its mean; 0 at NODATA
+    double (*rr_h)[24];     // [ndays][N][24]
+    float (*frag)[24];      // [ndays][N][24]: the fragments rr_h / rr_d (sum to 1); 0 at dry sites
+    int own;                // 1: the rr_h block was allocated (compacted) by donor_build()
+};
+
 struct df_cp
 {
     /* 
@@ -76,9 +118,18 @@ struct Para_global
         char FP_CP[200];        // file path of circulation pattern (CP) classification data series
         char FP_HOURLY[200];    // file path of hourly precipitation data (as fragments)
         char FP_OUT[200];       // file path of output(hourly) precipitation from disaggregation
+        char FP_ARCHIVE[200];   // file path of the binary (compiled) hourly archive
+        char OUT_FORMAT[10];    // format of the output (FP_OUT): CSV, BINARY, SPARSE or NONE
+        char OUT_PARTITION[10]; // one output file per RUN, YEAR or STATION; NONE: all in FP_OUT
+        char APPEND[10];        // TRUE: only the days after the end of FP_OUT are disaggregated and appended
+        char FP_PROVENANCE[200]; // file path of the provenance log (donors of each day); FALSE: none
+        char REPLAY[10];        // TRUE: the donors are replayed from FP_PROVENANCE instead of sampled
+        char FP_STATS[200];     // file path of the summary statistics of the output; FALSE: none
+        char FP_BALANCE[200];   // file path of the mass balance report; FALSE: no verification
         
         char FP_LOG[200];       // file path of log file
         char FP_SSIM[200];      // file path of the output SSIM file
+        char SSIM_FORMAT[16];   // format of the SSIM file: TEXT, TEXT_DEPTH or BINARY
 
         char SIMILARITY[10];    // the similarity index: Manhattan or SSIM
         int PREPROCESS;         // preprocess the data by normalization or standardization
@@ -93,6 +144,15 @@ struct Para_global
         int CONTINUITY;         // continuity day
         int WD;                 // the flexibility level of wet-dry status in candidates filtering
         int CLASS_N;            // total categories the series is classified into
+        int STREAM_WINDOW;      // window size (days) to stream the daily data; 0: import the whole series
+        int N_THREAD;           // number of threads to import the data files
+        int OUT_QUEUE;          // capacity (days) of the output queue of the writing thread; 0: write directly
+        int APPEND_AFTER;       // append or restart: day number of the last day in the output; -1: a new output
+        int CHECKPOINT;         // a checkpoint every CHECKPOINT target days; 0: no checkpoints
+        char RESTART[10];       // TRUE: resume from the checkpoint FP_OUT.ckpt
+        long long SEED;         // seed of the random number generator; 0: seeded by the clock
+        int DATE_FROM;          // START_DATE (yyyymmdd): the first target day of FP_DAILY; 0: from the beginning
+        int DATE_TO;            // END_DATE (yyyymmdd): the last target day of FP_DAILY
 
         /*************
          * SSIM parameters
@@ -102,6 +162,12 @@ struct Para_global
         double NODATA;          // nodata value
         int flag_SSIM;          // flag, whether to write SSIM 
         int FLAG_LOG;           // flag, whether to write log
+        int FLAG_ARCHIVE;       // flag, whether to use (compile) the binary hourly archive
+        int FLAG_APPEND;        // flag, append mode
+        int FLAG_RESTART;       // flag, restart from the checkpoint
+        int FLAG_PROVENANCE;    // flag, provenance log: 0, none; 1, record; 2, replay
+        int FLAG_STATS;         // flag, whether to write the summary statistics (FP_STATS)
+        int FLAG_BALANCE;       // flag, whether to verify the mass balance (FP_BALANCE)
         int RUN;                // simulation runs 
     };
 
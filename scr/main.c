@@ -13,6 +13,14 @@
 #include "Func_Prepro.h"
 #include "Func_Recursive.h"
 #include "Func_Print.h"
+#include "Func_Archive.h"
+#include "Func_Ingest.h"
+#include "Func_Diag.h"
+#include "Func_Append.h"
+#include "Func_Checkpoint.h"
+#include "Func_Provenance.h"
+#include "Func_Stats.h"
+#include "Func_Balance.h"
 
 /****** exit description *****
  * void exit(int status);
@@ -30,7 +38,6 @@
  *
  *****************************/
 
-FILE *p_SSIM;
 FILE *p_log;  // file pointer pointing to log file
 int FLAG_LOG;
 
@@ -57,6 +64,11 @@ int main(int argc, char * argv[]) {
     argv[1]: pointing to the second string (parameter): file path and name of global parameter file.
     */
     import_global(*(++argv), p_gp);
+    if (is_std(p_gp->FP_OUT))
+    {
+        // FP_OUT "-": the hourly output goes to the standard output, the messages to the standard error
+        stream_stdout_reserve();
+    }
     FLAG_LOG = p_gp->FLAG_LOG;
     if (FLAG_LOG == 1)
     {
@@ -69,10 +81,17 @@ int main(int argc, char * argv[]) {
     Print_gp(p_gp);
     /******* import circulation pattern series *********/
     
-    static struct df_cp df_cps[MAXrow];
+    struct df_cp *df_cps = NULL;  // allocated in import_df_cp(), sized from the data file
     int nrow_cp=0;  // the number of CP data columns: 4 (y, m, d, cp)
     if (strncmp(p_gp->T_CP, "TRUE", 4) == 0) {
-        nrow_cp = import_df_cp(Para_df.FP_CP, df_cps);
+        if (p_gp->N_THREAD > 1)
+        {
+            nrow_cp = import_df_cp_parallel(Para_df.FP_CP, p_gp->N_THREAD, &df_cps);
+        }
+        else
+        {
+            nrow_cp = import_df_cp(Para_df.FP_CP, &df_cps);
+        }
         Print_cp(df_cps, nrow_cp);
     }
     if (strncmp(p_gp->MONTH, "TRUE", 4) == 0)
@@ -95,25 +114,71 @@ int main(int argc, char * argv[]) {
 
     /****** import daily rainfall data (to be disaggregated) *******/
     
-    static struct df_rr_d df_rr_daily[MAXrow];
-    int nrow_rr_d;
-    nrow_rr_d = import_dfrr_d(Para_df.FP_DAILY, Para_df.N_STATION, df_rr_daily);
-    initialize_dfrr_d(p_gp, df_rr_daily, df_cps, nrow_rr_d, nrow_cp);
-    Print_dly(df_rr_daily, p_gp, nrow_rr_d);
+    struct df_rr_d *df_rr_daily = NULL;  // allocated in import_dfrr_d()
+    int nrow_rr_d = 0;
+    if (p_gp->STREAM_WINDOW <= 0)
+    {
+        if (p_gp->N_THREAD > 1)
+        {
+            nrow_rr_d = import_dfrr_d_parallel(Para_df.FP_DAILY, Para_df.N_STATION, p_gp->N_THREAD, p_gp->DATE_FROM, p_gp->DATE_TO, &df_rr_daily);
+        }
+        else
+        {
+            nrow_rr_d = import_dfrr_d(Para_df.FP_DAILY, Para_df.N_STATION, p_gp->DATE_FROM, p_gp->DATE_TO, &df_rr_daily);
+        }
+        if (nrow_rr_d <= 0)
+        {
+            printf("Program terminated: no days in the daily rr data file (START_DATE - END_DATE): %s\n", Para_df.FP_DAILY);
+            exit(1);
+        }
+        initialize_dfrr_d(p_gp, df_rr_daily, df_cps, nrow_rr_d, nrow_cp);
+        Print_dly(df_rr_daily, p_gp, nrow_rr_d);
+    }
+    else
+    {
+        // streaming: the daily data are imported window by window during disaggregation
+        printf("------ Daily data are streamed in windows of %d days\n", p_gp->STREAM_WINDOW);
+        if (FLAG_LOG == 1)
+        {
+            fprintf(p_log, "------ Daily data are streamed in windows of %d days\n", p_gp->STREAM_WINDOW);
+        }
+    }
 
     /****** import hourly rainfall data (obs as fragments) *******/
     
-    int ndays_h;
-    static struct df_rr_h df_rr_hourly[MAXrow];
-    ndays_h = import_dfrr_h(Para_df.FP_HOURLY, Para_df.N_STATION, df_rr_hourly);
-    initialize_dfrr_h(p_gp, df_rr_hourly, df_cps, ndays_h, nrow_cp);
+    int ndays_h = -1;
+    int flag_compile = 0;  // whether the binary hourly archive is (re)compiled in this run
+    struct df_rr_h *df_rr_hourly = NULL;  // allocated in import_dfrr_h() or load_archive()
+    if (p_gp->FLAG_ARCHIVE == 1)
+    {
+        ndays_h = load_archive(p_gp, &df_rr_hourly);
+        flag_compile = (ndays_h < 0);
+    }
+    if (ndays_h < 0)
+    {
+        if (p_gp->N_THREAD > 1)
+        {
+            ndays_h = import_dfrr_h_parallel(Para_df.FP_HOURLY, Para_df.N_STATION, p_gp->N_THREAD, &df_rr_hourly);
+        }
+        else
+        {
+            ndays_h = import_dfrr_h(Para_df.FP_HOURLY, Para_df.N_STATION, &df_rr_hourly);
+        }
+        initialize_dfrr_h(p_gp, df_rr_hourly, df_cps, ndays_h, nrow_cp);
+    }
     Print_hly(df_rr_hourly, ndays_h);
 
     /****** rainfall data preprocessing: wet-dry status initialization *******/
-    initialize_dfrr_wd(p_gp, df_rr_daily, df_rr_hourly, nrow_rr_d, ndays_h);
+    // the wet-dry status of the hourly obs is already stored in the archive
+    initialize_dfrr_wd(p_gp, df_rr_daily, df_rr_hourly, nrow_rr_d,
+                       (p_gp->FLAG_ARCHIVE == 1 && flag_compile == 0) ? 0 : ndays_h);
+    if (flag_compile == 1)
+    {
+        write_archive(p_gp, df_rr_hourly, ndays_h);
+    }
     /****** rainfall data preprocessing: normalization / standardization *******/
     // preprocessing of the data: none [0], normalization [1] or standardization [2]
-    if (p_gp->PREPROCESS != 0)
+    if (p_gp->PREPROCESS != 0 && p_gp->STREAM_WINDOW <= 0)
     {
         if (p_gp->PREPROCESS == 1)
         {
@@ -128,28 +193,62 @@ int main(int argc, char * argv[]) {
     }
     
     /****** Disaggregation: kNN_MOF_cp *******/
-    if (p_gp->flag_SSIM == 1)  // if (strncmp(p_gp->FP_SSIM, "FALSE", 5) == 0)
+    if (p_gp->SEED != 0)
     {
-        if ((p_SSIM = fopen(p_gp->FP_SSIM, "w")) == NULL)
-        {
-            printf("Cannot create / open SSIM file: %s\n", p_gp->FP_SSIM);
-            exit(1);
-        }
-        if (FLAG_LOG == 1)
+        rng_seed((unsigned long long)p_gp->SEED);
+    }
+    if (p_gp->CHECKPOINT > 0 || p_gp->FLAG_RESTART == 1)
+    {
+        // restart: the checkpoint (if any) takes the place of the append state
+        if (checkpoint_init(p_gp) != 0 && p_gp->FLAG_APPEND == 1)
         {
-            fprintf(p_SSIM, "target,ID,index_Frag,SSIM,candidate\n");
+            append_last_day(p_gp);
         }
     }
+    else if (p_gp->FLAG_APPEND == 1)
+    {
+        append_last_day(p_gp);
+    }
+    if (p_gp->flag_SSIM == 1)  // if (strncmp(p_gp->FP_SSIM, "FALSE", 5) == 0)
+    {
+        diag_open(p_gp);
+    }
+
+    if (p_gp->FLAG_STATS == 1)
+    {
+        stats_open(p_gp);
+    }
+    if (p_gp->FLAG_BALANCE == 1)
+    {
+        balance_open(p_gp);
+    }
+    if (p_gp->FLAG_PROVENANCE != 0)
+    {
+        prov_open(p_gp, df_rr_hourly, ndays_h);
+    }
 
     printf("------ Disaggregating: ... \n");
-    kNN_MOF_SSIM_Recursive(
-        df_rr_hourly,
-        df_rr_daily,
-        df_cps,
-        p_gp,
-        nrow_rr_d,
-        ndays_h,
-        nrow_cp);
+    if (p_gp->STREAM_WINDOW > 0)
+    {
+        // the data preprocessing (if any) is done within the streaming
+        kNN_MOF_SSIM_Recursive_stream(
+            df_rr_hourly,
+            df_cps,
+            p_gp,
+            ndays_h,
+            nrow_cp);
+    }
+    else
+    {
+        kNN_MOF_SSIM_Recursive(
+            df_rr_hourly,
+            df_rr_daily,
+            df_cps,
+            p_gp,
+            nrow_rr_d,
+            ndays_h,
+            nrow_cp);
+    }
     // kNN_MOF_SSIM(
     //     df_rr_hourly,
     //     df_rr_daily,
@@ -160,7 +259,23 @@ int main(int argc, char * argv[]) {
     //     ndays_h,
     //     nrow_cp);
     if (p_gp->flag_SSIM == 1){
-        fclose(p_SSIM);
+        diag_close();
+    }
+    if (p_gp->CHECKPOINT > 0 || p_gp->FLAG_RESTART == 1)
+    {
+        checkpoint_done(p_gp);
+    }
+    if (p_gp->FLAG_PROVENANCE != 0)
+    {
+        prov_close();
+    }
+    if (p_gp->FLAG_STATS == 1)
+    {
+        stats_close();
+    }
+    if (p_gp->FLAG_BALANCE == 1)
+    {
+        balance_close();
     }
     time(&tm);
     printf("------ Disaggregation daily2hourly (Done): %s", ctime(&tm));
@@ -0,0 +1,409 @@
+/*
+ * SUMMARY:      main_bin2csv.c
+ * USAGE:        convert the binary (OUT_FORMAT,BINARY) or sparse (SPARSE) output into csv
+ * AUTHOR:       Xiaoxiang Guan
+ * ORG:          Section Hydrology, GFZ
+ * E-MAIL:       guan@gfz-potsdam.de
+ * ORIG-DATE:    Oct-2026
+ * DESCRIPTION:  writes the same csv layout as the text output of kNN_MOF_SSIM:
+ *               [run,]y,m,d,h,rr_1,...,rr_N; optionally only one station
+ *               and (or) a date range, which is located with the day index of
+ *               the binary file, without reading the other days.
+ *               the sparse output (text, can be gzip-compressed) is read row
+ *               by row; the values which are not stored are written as 0.00.
+ *               the binary SSIM diagnostics (SSIM_FORMAT,BINARY) are written as
+ *               target,depth,ID,index_Frag,SSIM,candidate
+ * DESCRIP-END.
+ * FUNCTIONS:    main(); date_key(); parse_date(); write_day(); sparse2csv(); diag2csv();
+ *
+ * COMMENTS:
+ * ./kNN_MOF_bin2csv FP_BIN FP_CSV [-s STATION] [-f yyyy-mm-dd] [-t yyyy-mm-dd]
+ *      STATION: the index of the station (column), from 1
+ *      -f, -t: the first and the last day to convert
+ *      FP_CSV ending with ".gz" is gzip-compressed
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "def_struct.h"
+#include "Func_Format.h"
+#include "Func_BinOut.h"
+#include "Func_Stream.h"
+#include "Func_Diag.h"
+
+static int date_key(
+    int y, int m, int d)
+{
+    return y * 10000 + m * 100 + d;
+}
+
+static int parse_date(
+    char *s)
+{
+    // yyyy-mm-dd into the key yyyymmdd
+    int y, m, d;
+    if (sscanf(s, "%d-%d-%d", &y, &m, &d) != 3)
+    {
+        printf("Invalid date (yyyy-mm-dd): %s\n", s);
+        exit(1);
+    }
+    return date_key(y, m, d);
+}
+
+static void write_day(
+    struct out_buf *p_buf,
+    int date[],
+    int RUN,
+    int N,
+    int station,
+    double *rr)
+{
+    // append the csv rows of one day (all runs); rr: [RUN][24][N]
+    int r, h, j, len_prefix;
+    char prefix[64];
+    for (r = 0; r < RUN; r++)
+    {
+        if (RUN == 1)
+        {
+            len_prefix = snprintf(prefix, sizeof(prefix), "%d,%d,%d,", date[0], date[1], date[2]);
+        }
+        else
+        {
+            len_prefix = snprintf(prefix, sizeof(prefix), "%d,%d,%d,%d,", r + 1, date[0], date[1], date[2]);
+        }
+        for (h = 0; h < 24; h++)
+        {
+            buf_reserve(p_buf, len_prefix + 4);
+            memcpy(p_buf->data + p_buf->len, prefix, len_prefix);
+            p_buf->len += len_prefix;
+            p_buf->len += snprintf(p_buf->data + p_buf->len, 4, "%d", h);
+            for (j = 0; j < N; j++)
+            {
+                if (station > 0 && j != station - 1)
+                {
+                    continue;
+                }
+                buf_reserve(p_buf, 402);
+                p_buf->data[p_buf->len++] = ',';
+                p_buf->len += format_fixed2(rr[((size_t)r * 24 + h) * N + j], p_buf->data + p_buf->len);
+            }
+            p_buf->data[p_buf->len++] = '\n';
+        }
+    }
+}
+
+static void sparse2csv(
+    struct stream_in *p_in,
+    struct stream_out *p_csv,
+    int station,
+    int key_from,
+    int key_to)
+{
+    /**************
+     * Description:
+     *      expand the sparse output (rows: run,y,m,d,n,station,hour,rr,...)
+     *      into the csv layout, day by day
+     * ***********/
+    char *row = NULL;
+    size_t size = 1 << 16, len;
+    int N, RUN, run, n, k, j, h, key, key_day = -1;
+    int date[3], date_day[3];
+    double *rr = NULL;
+    char *p, *q;
+    struct out_buf buf;
+    memset(&buf, 0, sizeof(struct out_buf));
+    row = (char *)malloc(size);
+    if (stream_gets(row, (int)size, p_in) == NULL || sscanf(row, "#SPARSE,%d,%d", &N, &RUN) != 2)
+    {
+        printf("Not a sparse output file of kNN_MOF_SSIM\n");
+        exit(1);
+    }
+    if (station < 0 || station > N)
+    {
+        printf("Invalid station: %d (1 - %d)\n", station, N);
+        exit(1);
+    }
+    rr = (double *)calloc((size_t)RUN * 24 * N, sizeof(double));
+    while (1)
+    {
+        /* a whole row of any length */
+        len = 0;
+        while (stream_gets(row + len, (int)(size - len), p_in) != NULL)
+        {
+            len += strlen(row + len);
+            if (row[len - 1] == '\n' || len < size - 1)
+            {
+                break;
+            }
+            size *= 2;
+            row = (char *)realloc(row, size);
+        }
+        run = -1;
+        if (len > 0)
+        {
+            p = row;
+            run = (int)strtol(p, &q, 10);
+            date[0] = (int)strtol(q + 1, &q, 10);
+            date[1] = (int)strtol(q + 1, &q, 10);
+            date[2] = (int)strtol(q + 1, &q, 10);
+            n = (int)strtol(q + 1, &q, 10);
+        }
+        key = (run >= 0) ? date_key(date[0], date[1], date[2]) : -1;
+        if (key != key_day && key_day >= key_from && key_day <= key_to)
+        {
+            /* the previous day is complete */
+            buf.len = 0;
+            write_day(&buf, date_day, RUN, N, station, rr);
+            if (stream_write(buf.data, buf.len, p_csv) != buf.len)
+            {
+                printf("Error in writing csv file\n");
+                exit(1);
+            }
+        }
+        if (run < 0)
+        {
+            break; // end of the file
+        }
+        if (key != key_day)
+        {
+            memset(rr, 0, sizeof(double) * RUN * 24 * N);
+            key_day = key;
+            memcpy(date_day, date, sizeof(date));
+        }
+        if (run < 1 || run > RUN || key < key_from || key > key_to)
+        {
+            continue; // the marker of a dry day, or out of the date range
+        }
+        for (k = 0; k < n; k++)
+        {
+            j = (int)strtol(q + 1, &q, 10);
+            h = (int)strtol(q + 1, &q, 10);
+            if (j < 1 || j > N || h < 0 || h > 23)
+            {
+                printf("Invalid station or hour in the sparse output: %d-%02d-%02d\n", date[0], date[1], date[2]);
+                exit(1);
+            }
+            rr[((size_t)(run - 1) * 24 + h) * N + j - 1] = strtod(q + 1, &q);
+        }
+    }
+    free(row);
+    free(rr);
+    buf_free(&buf);
+}
+
+static void diag2csv(
+    FILE *fp,
+    struct stream_out *p_csv,
+    int key_from,
+    int key_to)
+{
+    // the records of the binary SSIM diagnostics, with the target day in the date range
+    struct diag_header head;
+    struct diag_record rec[1024];
+    struct out_buf buf;
+    size_t n, i;
+    if (fread(&head, sizeof(struct diag_header), 1, fp) != 1 ||
+        head.version != DIAG_VERSION || head.byte_order != 0x01020304 ||
+        head.record_size != (int)sizeof(struct diag_record))
+    {
+        printf("Not a binary SSIM file of kNN_MOF_SSIM\n");
+        exit(1);
+    }
+    memset(&buf, 0, sizeof(struct out_buf));
+    buf_reserve(&buf, 64);
+    buf.len = sprintf(buf.data, "target,depth,ID,index_Frag,SSIM,candidate\n");
+    while ((n = fread(rec, sizeof(struct diag_record), 1024, fp)) > 0)
+    {
+        for (i = 0; i < n; i++)
+        {
+            if (rec[i].target < key_from || rec[i].target > key_to)
+            {
+                continue;
+            }
+            buf_reserve(&buf, 128);
+            buf.len += snprintf(
+                buf.data + buf.len, 128, "%d-%02d-%02d,%d,%d,%d,%f,%d-%02d-%02d\n",
+                rec[i].target / 10000, rec[i].target / 100 % 100, rec[i].target % 100,
+                rec[i].depth, rec[i].rank, rec[i].candidate, rec[i].score,
+                rec[i].candidate_date / 10000, rec[i].candidate_date / 100 % 100, rec[i].candidate_date % 100);
+        }
+        if (stream_write(buf.data, buf.len, p_csv) != buf.len)
+        {
+            printf("Error in writing csv file\n");
+            exit(1);
+        }
+        buf.len = 0;
+    }
+    buf_free(&buf);
+}
+
+int main(int argc, char *argv[])
+{
+    struct binout_header head;
+    long long *index;
+    FILE *fp_bin;
+    struct stream_out fp_csv;
+    int i, k, N, station = 0;
+    int key_from = 0, key_to = 99999999;
+    int lo, hi, mid, date[3];
+    uint16_t *p_rec, v;
+    double *rr;
+    struct out_buf buf;
+
+    if (argc < 3)
+    {
+        printf("Usage: %s FP_BIN FP_CSV [-s STATION] [-f yyyy-mm-dd] [-t yyyy-mm-dd]\n", argv[0]);
+        exit(1);
+    }
+    for (k = 3; k + 1 < argc; k += 2)
+    {
+        if (strcmp(argv[k], "-s") == 0)
+        {
+            station = atoi(argv[k + 1]);
+        }
+        else if (strcmp(argv[k], "-f") == 0)
+        {
+            key_from = parse_date(argv[k + 1]);
+        }
+        else if (strcmp(argv[k], "-t") == 0)
+        {
+            key_to = parse_date(argv[k + 1]);
+        }
+        else
+        {
+            printf("Unknown option: %s\n", argv[k]);
+            exit(1);
+        }
+    }
+
+    /* the sparse output is text, beginning with "#SPARSE" */
+    struct stream_in fp_in;
+    char magic[8] = {0};
+    if (stream_open_in(&fp_in, argv[1]) != 0)
+    {
+        printf("Cannot open output file: %s\n", argv[1]);
+        exit(1);
+    }
+    if (stream_gets(magic, sizeof(magic), &fp_in) != NULL && strncmp(magic, "#SPARSE", 7) == 0)
+    {
+        stream_rewind(&fp_in);
+        if (stream_open_out(&fp_csv, argv[2], "w") != 0)
+        {
+            printf("Cannot create or open csv file: %s\n", argv[2]);
+            exit(1);
+        }
+        sparse2csv(&fp_in, &fp_csv, station, key_from, key_to);
+        stream_close_in(&fp_in);
+        if (stream_close_out(&fp_csv) != 0)
+        {
+            printf("Error in writing csv file: %s\n", argv[2]);
+            exit(1);
+        }
+        return 0;
+    }
+    stream_close_in(&fp_in);
+
+    if ((fp_bin = fopen(argv[1], "rb")) == NULL)
+    {
+        printf("Cannot open binary output file: %s\n", argv[1]);
+        exit(1);
+    }
+    if (strncmp(magic, "KNNMOFD", 7) == 0)
+    {
+        /* the binary SSIM diagnostics */
+        if (stream_open_out(&fp_csv, argv[2], "w") != 0)
+        {
+            printf("Cannot create or open csv file: %s\n", argv[2]);
+            exit(1);
+        }
+        diag2csv(fp_bin, &fp_csv, key_from, key_to);
+        fclose(fp_bin);
+        if (stream_close_out(&fp_csv) != 0)
+        {
+            printf("Error in writing csv file: %s\n", argv[2]);
+            exit(1);
+        }
+        return 0;
+    }
+    if (binout_read_header(fp_bin, &head) != 0 || (index = binout_read_index(fp_bin, &head)) == NULL)
+    {
+        printf("Not a (complete) binary output file of kNN_MOF_SSIM: %s\n", argv[1]);
+        exit(1);
+    }
+    N = head.N_STATION;
+    if (station < 0 || station > N)
+    {
+        printf("Invalid station: %d (1 - %d)\n", station, N);
+        exit(1);
+    }
+    if (stream_open_out(&fp_csv, argv[2], "w") != 0)
+    {
+        printf("Cannot create or open csv file: %s\n", argv[2]);
+        exit(1);
+    }
+
+    /* the first day of the range: binary search, the days are in ascending order */
+    lo = 0;
+    hi = head.ndays;
+    while (lo < hi)
+    {
+        mid = (lo + hi) / 2;
+        fseek(fp_bin, index[mid], SEEK_SET);
+        if (fread(date, sizeof(int), 3, fp_bin) != 3)
+        {
+            printf("Error in reading binary output file: %s\n", argv[1]);
+            exit(1);
+        }
+        if (date_key(date[0], date[1], date[2]) < key_from)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    memset(&buf, 0, sizeof(struct out_buf));
+    p_rec = (uint16_t *)malloc(head.record_size);
+    rr = (double *)malloc(sizeof(double) * head.RUN * 24 * N);
+    for (i = lo; i < head.ndays; i++)
+    {
+        fseek(fp_bin, index[i], SEEK_SET);
+        if (fread(date, sizeof(int), 3, fp_bin) != 3 ||
+            fread(p_rec, 1, head.record_size - 3 * sizeof(int), fp_bin) != (size_t)(head.record_size - 3 * sizeof(int)))
+        {
+            printf("Error in reading binary output file: %s\n", argv[1]);
+            exit(1);
+        }
+        if (date_key(date[0], date[1], date[2]) > key_to)
+        {
+            break;
+        }
+        buf.len = 0;
+        for (k = 0; k < head.RUN * 24 * N; k++)
+        {
+            v = p_rec[k];
+            rr[k] = (v == BINOUT_NODATA) ? head.NODATA : (double)v / BINOUT_SCALE;
+        }
+        write_day(&buf, date, head.RUN, N, station, rr);
+        if (stream_write(buf.data, buf.len, &fp_csv) != buf.len)
+        {
+            printf("Error in writing csv file: %s\n", argv[2]);
+            exit(1);
+        }
+    }
+    if (stream_close_out(&fp_csv) != 0)
+    {
+        printf("Error in writing csv file: %s\n", argv[2]);
+        exit(1);
+    }
+    fclose(fp_bin);
+    free(p_rec);
+    free(rr);
+    free(index);
+    buf_free(&buf);
+    return 0;
+}